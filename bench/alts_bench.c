@@ -0,0 +1,516 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Latency of every public function over a synthetic configuration tree.
+ *
+ * The tree has N binaries with P priorities each. Every options file
+ * lists M manpages and a group of G binaries, and the user override
+ * file has K entries, half of them for installed binaries. Each function
+ * is called round robin over the binaries, first for warm-up and then
+ * timed call by call, and percentiles of the calls are printed, along
+ * with the mean allocations and the highest peak heap use of a call,
+ * counted by test/alloc_counter.c, including freeing the results. Writing
+ * functions come last, since they change the overrides and the
+ * generation.
+ *
+ * Like inherit_bench, this links the test library, which can be pointed
+ * at another configuration directory. System overrides are read from
+ * the test tree, and the usage counter and generation files of the test
+ * library are removed afterwards.
+ */
+
+#define _GNU_SOURCE
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/libalternatives.h"
+#include "../test/alloc_counter.h"
+
+extern void setConfigDirectory(const char *);
+
+static char tree_path[] = "/tmp/libalternatives_alts_bench_XXXXXX";
+static char config_dir[64], override_path[128], launcher_dir[64];
+static int n_binaries = 100, n_priorities = 5, n_manpages = 4, n_group = 1, n_overrides = 50;
+static int iterations = 1000, warmup = 100;
+static const char *filter = NULL;
+
+static char **binary_names;
+
+static const char* binaryName(unsigned i)
+{
+	return binary_names[i % n_binaries];
+}
+
+static int priorityOf(unsigned i)
+{
+	return 10 * (1 + (i / n_binaries) % n_priorities);
+}
+
+static int writeOptionsFile(int binary, int priority)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s/%d.conf", config_dir, binary_names[binary], priority);
+	FILE *f = fopen(path, "w");
+	if (f == NULL)
+		return -1;
+
+	fprintf(f, "binary=/bin/true\n");
+	for (int i=0; i<n_manpages; i++)
+		fprintf(f, "%s%s-%d.%d", i == 0 ? "man=" : ",", binary_names[binary], priority, i + 1);
+	if (n_manpages > 0)
+		fputc('\n', f);
+
+	// groups of G consecutive binaries
+	const int first = binary - binary % n_group;
+	for (int i=first; n_group > 1 && i < first + n_group && i < n_binaries; i++)
+		fprintf(f, "%s%s", i == first ? "group=" : ",", binary_names[i]);
+	if (n_group > 1)
+		fputc('\n', f);
+
+	return fclose(f);
+}
+
+// launchers and the inherited cache do not trust recent modification times
+static void setPastTime(const char *path)
+{
+	struct timespec times[2] = {{1000000, 0}, {1000000, 0}};
+	utimensat(AT_FDCWD, path, times, 0);
+}
+
+static int createTree()
+{
+	char path[PATH_MAX];
+
+	if (mkdtemp(tree_path) == NULL)
+		return -1;
+
+	snprintf(config_dir, sizeof(config_dir), "%s/config", tree_path);
+	if (mkdir(config_dir, 0755) < 0)
+		return -1;
+
+	binary_names = calloc(n_binaries, sizeof(char*));
+	if (binary_names == NULL)
+		return -1;
+
+	for (int i=0; i<n_binaries; i++) {
+		if (asprintf(&binary_names[i], "bin%d", i) < 0)
+			return -1;
+
+		snprintf(path, sizeof(path), "%s/%s", config_dir, binary_names[i]);
+		if (mkdir(path, 0755) < 0)
+			return -1;
+		for (int prio=1; prio<=n_priorities; prio++) {
+			if (writeOptionsFile(i, 10 * prio) < 0)
+				return -1;
+		}
+		setPastTime(path);
+	}
+
+	snprintf(path, sizeof(path), "%s/user", tree_path);
+	snprintf(launcher_dir, sizeof(launcher_dir), "%s/launchers", tree_path);
+	snprintf(override_path, sizeof(override_path), "%s/user/libalternatives.conf", tree_path);
+	if (mkdir(path, 0755) < 0 || mkdir(launcher_dir, 0755) < 0)
+		return -1;
+
+	FILE *f = fopen(override_path, "w");
+	if (f == NULL)
+		return -1;
+	for (int i=0; i<n_overrides; i++) {
+		if (i % 2 == 0)
+			fprintf(f, "%s=%d\n", binaryName(i / 2), 10);
+		else
+			fprintf(f, "unrelated%d=%d\n", i, 10);
+	}
+	fclose(f);
+
+	setPastTime(override_path);
+	setPastTime(path);
+	setPastTime(config_dir);
+
+	setenv("XDG_CONFIG_HOME", path, 1);
+	setConfigDirectory(config_dir);
+	return 0;
+}
+
+static int removeTreeEntry(const char *path, __attribute__((unused)) const struct stat *st, __attribute__((unused)) int flag, __attribute__((unused)) struct FTW *ftw)
+{
+	return remove(path);
+}
+
+/* benchmarked calls, i selects binary and priority, return -1 on error */
+
+static struct AlternativeLink *loaded_alts;
+
+static int loadHighest(unsigned i)
+{
+	struct AlternativeLink *alts;
+	const int ret = libalts_load_highest_priority_binary_alternatives(binaryName(i), &alts);
+	libalts_free_alternatives_ptr(&alts);
+	return ret;
+}
+
+static int loadExact(unsigned i)
+{
+	struct AlternativeLink *alts;
+	const int ret = libalts_load_exact_priority_binary_alternatives(binaryName(i), priorityOf(i), &alts);
+	libalts_free_alternatives_ptr(&alts);
+	return ret;
+}
+
+static int prepareFree(unsigned i)
+{
+	return libalts_load_highest_priority_binary_alternatives(binaryName(i), &loaded_alts);
+}
+
+static int freeAlternatives(__attribute__((unused)) unsigned i)
+{
+	libalts_free_alternatives_ptr(&loaded_alts);
+	return 0;
+}
+
+static int loadAvailableBinaries(__attribute__((unused)) unsigned i)
+{
+	char **binaries;
+	size_t size;
+
+	if (libalts_load_available_binaries(&binaries, &size) != 0)
+		return -1;
+	for (size_t j=0; j<size; j++)
+		free(binaries[j]);
+	free(binaries);
+	return 0;
+}
+
+static int loadBinaryPriorities(unsigned i)
+{
+	int *priorities;
+	size_t size;
+
+	const int ret = libalts_load_binary_priorities(binaryName(i), &priorities, &size);
+	free(priorities);
+	return ret;
+}
+
+static int readPriorityFromFile(unsigned i)
+{
+	return libalts_read_binary_configured_priority_from_file(binaryName(i), override_path) < 0 ? -1 : 0;
+}
+
+static int readConfiguredPriority(unsigned i)
+{
+	return libalts_read_configured_priority(binaryName(i), NULL) < 0 ? -1 : 0;
+}
+
+static int getSystemConfigPath(__attribute__((unused)) unsigned i)
+{
+	return libalts_get_system_config_path() != NULL ? 0 : -1;
+}
+
+static int getUserConfigPath(__attribute__((unused)) unsigned i)
+{
+	return libalts_get_user_config_path() != NULL ? 0 : -1;
+}
+
+static int resolveDefaultBinary(unsigned i)
+{
+	char *target;
+	int options;
+
+	if (libalts_resolve_default_binary(binaryName(i), &target, &options) != 0)
+		return -1;
+	free(target);
+	return 0;
+}
+
+static int getDefaultManpages(unsigned i)
+{
+	char **manpages = libalts_get_default_manpages(binaryName(i));
+
+	if (manpages == NULL)
+		return -1;
+	for (char **p = manpages; *p != NULL; p++)
+		free(*p);
+	free(manpages);
+	return 0;
+}
+
+// the child executes /bin/true, so this includes fork and exec
+static int execDefault(unsigned i)
+{
+	char *argv[] = { (char*)binaryName(i), NULL };
+	int status;
+
+	const pid_t pid = fork();
+	if (pid == 0) {
+		libalts_exec_default(argv);
+		_exit(127);
+	}
+	if (pid < 0 || waitpid(pid, &status, 0) != pid)
+		return -1;
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+static int exportInheritedCache(unsigned i)
+{
+	return libalts_export_inherited_cache(binaryName(i));
+}
+
+static int generateLauncher(unsigned i)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s", launcher_dir, binaryName(i));
+	return libalts_generate_launcher(binaryName(i), path);
+}
+
+static int getGeneration(__attribute__((unused)) unsigned i)
+{
+	unsigned long long generation;
+	return libalts_get_generation(&generation);
+}
+
+static int getGenerationPath(__attribute__((unused)) unsigned i)
+{
+	return libalts_get_generation_path() != NULL ? 0 : -1;
+}
+
+static int bumpGeneration(__attribute__((unused)) unsigned i)
+{
+	return libalts_bump_generation();
+}
+
+// sets and resets overrides, so the file keeps its size
+static int writePriorityToFile(unsigned i)
+{
+	return libalts_write_binary_configured_priority_to_file(binaryName(i / 2), i % 2 == 0 ? priorityOf(i) : 0, override_path);
+}
+
+static int resetUsage(__attribute__((unused)) unsigned i)
+{
+	return libalts_reset_usage();
+}
+
+static int getUsagePath(__attribute__((unused)) unsigned i)
+{
+	return libalts_get_usage_path() != NULL ? 0 : -1;
+}
+
+static int loadUsage(__attribute__((unused)) unsigned i)
+{
+	struct LibaltsUsage *usage;
+	size_t size;
+
+	if (libalts_load_usage(&usage, &size) != 0)
+		return -1;
+	free(usage);
+	return 0;
+}
+
+static int getStats(__attribute__((unused)) unsigned i)
+{
+	struct LibaltsStats stats;
+	return libalts_get_stats(&stats, sizeof(stats));
+}
+
+static int enableInheritedCache()
+{
+	return setenv("LIBALTERNATIVES_CACHE", "", 1);
+}
+
+static int disableInheritedCache()
+{
+	return unsetenv("LIBALTERNATIVES_CACHE");
+}
+
+struct Benchmark
+{
+	const char *name;
+	int (*call)(unsigned i);
+	int (*prepare)(unsigned i); // untimed, before each call, or NULL
+	int max_iterations; // for slow calls, 0 for no limit
+	int (*setup)(); // before the benchmark, or NULL
+};
+
+static const struct Benchmark benchmarks[] = {
+	{"load_highest_priority_binary_alternatives", loadHighest, NULL, 0, NULL},
+	{"load_exact_priority_binary_alternatives", loadExact, NULL, 0, NULL},
+	{"free_alternatives_ptr", freeAlternatives, prepareFree, 0, NULL},
+	{"load_available_binaries", loadAvailableBinaries, NULL, 0, NULL},
+	{"load_binary_priorities", loadBinaryPriorities, NULL, 0, NULL},
+	{"read_binary_configured_priority_from_file", readPriorityFromFile, NULL, 0, NULL},
+	{"read_configured_priority", readConfiguredPriority, NULL, 0, NULL},
+	{"get_system_config_path", getSystemConfigPath, NULL, 0, NULL},
+	{"get_user_config_path", getUserConfigPath, NULL, 0, NULL},
+	{"resolve_default_binary", resolveDefaultBinary, NULL, 0, NULL},
+	{"get_default_manpages", getDefaultManpages, NULL, 0, NULL},
+	{"exec_default (fork, exec, wait)", execDefault, NULL, 200, NULL},
+	{"export_inherited_cache", exportInheritedCache, NULL, 0, enableInheritedCache},
+	{"generate_launcher", generateLauncher, NULL, 200, disableInheritedCache},
+	{"get_generation", getGeneration, NULL, 0, NULL},
+	{"get_generation_path", getGenerationPath, NULL, 0, NULL},
+	{"get_stats", getStats, NULL, 0, NULL},
+	{"get_usage_path", getUsagePath, NULL, 0, NULL},
+	{"reset_usage", resetUsage, NULL, 200, NULL},
+	{"load_usage", loadUsage, NULL, 0, NULL},
+	{"bump_generation", bumpGeneration, NULL, 200, NULL},
+	{"write_binary_configured_priority_to_file", writePriorityToFile, NULL, 200, NULL},
+};
+
+static int compareLong(const void *a, const void *b)
+{
+	const long long x = *(const long long*)a, y = *(const long long*)b;
+	return (x > y) - (x < y);
+}
+
+static long long elapsedNanoseconds(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1000000000LL + (end->tv_nsec - start->tv_nsec);
+}
+
+static void runBenchmark(const struct Benchmark *benchmark, long long *samples)
+{
+	const int n = benchmark->max_iterations > 0 && benchmark->max_iterations < iterations ? benchmark->max_iterations : iterations;
+	const int n_warmup = warmup < n ? warmup : n;
+	int errors = 0;
+	long long total = 0;
+	unsigned long allocations = 0;
+	long peak_bytes = 0;
+
+	if (benchmark->setup != NULL)
+		benchmark->setup();
+
+	for (int i=0; i<n_warmup; i++) {
+		if (benchmark->prepare != NULL)
+			benchmark->prepare(i);
+		benchmark->call(i);
+	}
+
+	for (int i=0; i<n; i++) {
+		struct timespec start, end;
+		struct AllocCount count;
+
+		if (benchmark->prepare != NULL)
+			benchmark->prepare(i);
+		startAllocCount();
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		errors += benchmark->call(i) != 0;
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		stopAllocCount(&count);
+
+		samples[i] = elapsedNanoseconds(&start, &end);
+		total += samples[i];
+		allocations += count.allocations;
+		if (count.peak_bytes > peak_bytes)
+			peak_bytes = count.peak_bytes;
+	}
+
+	qsort(samples, n, sizeof(long long), compareLong);
+	printf("%-52s %7d %7d %10lld %10lld %10lld %10lld %10lld %8.1f %8ld\n", benchmark->name, n, errors,
+	       total / n, samples[n / 2], samples[n * 9 / 10], samples[n * 99 / 100], samples[n - 1],
+	       (double)allocations / n, peak_bytes);
+}
+
+static void printHelp()
+{
+	puts("alts-bench [-n binaries] [-p priorities] [-m manpages] [-g group] [-k overrides]\n"
+	     "           [-i iterations] [-w warmup] [function]\n"
+	     "    -n -- binaries in the configuration tree (100)\n"
+	     "    -p -- priorities per binary (5)\n"
+	     "    -m -- manpages per options file (4)\n"
+	     "    -g -- binaries per group, 1 for no groups (1)\n"
+	     "    -k -- entries in the user override file (50)\n"
+	     "    -i -- timed calls per function (1000)\n"
+	     "    -w -- untimed warm-up calls per function (100)\n"
+	     "    function -- only functions containing this string");
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:p:m:g:k:i:w:h")) != -1) {
+		switch (opt) {
+			case 'n':
+				n_binaries = atoi(optarg);
+				break;
+			case 'p':
+				n_priorities = atoi(optarg);
+				break;
+			case 'm':
+				n_manpages = atoi(optarg);
+				break;
+			case 'g':
+				n_group = atoi(optarg);
+				break;
+			case 'k':
+				n_overrides = atoi(optarg);
+				break;
+			case 'i':
+				iterations = atoi(optarg);
+				break;
+			case 'w':
+				warmup = atoi(optarg);
+				break;
+			default:
+				printHelp();
+				return opt == 'h' ? 0 : 1;
+		}
+	}
+	if (optind < argc)
+		filter = argv[optind];
+
+	if (n_binaries < 1 || n_priorities < 1 || n_manpages < 0 || n_group < 1 || n_overrides < 0 || iterations < 1 || warmup < 0) {
+		printHelp();
+		return 1;
+	}
+
+	long long *samples = malloc(iterations * sizeof(long long));
+	if (samples == NULL || createTree() < 0) {
+		perror("Cannot create configuration tree");
+		return 1;
+	}
+
+	printf("%d binaries, %d priorities, %d manpages, groups of %d, %d overrides in %s\n\n",
+	       n_binaries, n_priorities, n_manpages, n_group, n_overrides, tree_path);
+	printf("%-52s %7s %7s %10s %10s %10s %10s %10s %8s %8s\n", "function", "calls", "errors",
+	       "mean_ns", "p50_ns", "p90_ns", "p99_ns", "max_ns", "allocs", "peak_B");
+
+	for (size_t i=0; i<sizeof(benchmarks)/sizeof(benchmarks[0]); i++) {
+		if (filter == NULL || strstr(benchmarks[i].name, filter) != NULL)
+			runBenchmark(benchmarks + i, samples);
+	}
+
+	nftw(tree_path, removeTreeEntry, 8, FTW_DEPTH | FTW_PHYS);
+	unlink(libalts_get_usage_path());
+	unlink(libalts_get_generation_path());
+	for (int i=0; i<n_binaries; i++)
+		free(binary_names[i]);
+	free(binary_names);
+	free(samples);
+	return 0;
+}
@@ -0,0 +1,464 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Replays calls captured with LIBALTERNATIVES_CAPTURE against a given
+ * configuration directory.
+ *
+ * The captured calls are dealt round robin to J worker processes, which
+ * are released together and each issue their share N times. Every call
+ * is timed, and its result is compared to the captured one, so a replay
+ * against another tree or library version also shows what resolves
+ * differently. Executions are replayed as resolve_default_binary, which
+ * resolves the same without executing. Calls that change the tree or
+ * the environment, like export_inherited_cache, are skipped.
+ *
+ * Like alts-bench, this links the test library, which can be pointed at
+ * another configuration directory. Overrides are read from and written
+ * to a scratch copy of the given user override, so unlike alts -s they
+ * do not bump the generation.
+ */
+
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/libalternatives.h"
+
+extern void setConfigDirectory(const char *);
+extern void setConfigPath(const char *config_path);
+
+#define SKIPPED INT_MIN
+
+struct Record
+{
+	int function;
+	char *binary_name;
+	int argument;
+	int result;
+};
+
+struct FunctionStats
+{
+	unsigned long calls;
+	unsigned long changed;
+	unsigned long skipped;
+	unsigned long long ns;
+};
+
+static char override_path[] = "/tmp/libalternatives_replay_XXXXXX";
+static int workers = 1, passes = 1;
+
+static struct Record *records;
+static size_t n_records;
+
+/* replayed calls, return the result as it is captured or SKIPPED */
+
+static int loadHighest(const struct Record *record)
+{
+	struct AlternativeLink *alts;
+	const int ret = libalts_load_highest_priority_binary_alternatives(record->binary_name, &alts);
+	libalts_free_alternatives_ptr(&alts);
+	return ret;
+}
+
+static int loadExact(const struct Record *record)
+{
+	struct AlternativeLink *alts;
+	const int ret = libalts_load_exact_priority_binary_alternatives(record->binary_name, record->argument, &alts);
+	libalts_free_alternatives_ptr(&alts);
+	return ret;
+}
+
+static int loadAvailableBinaries(const struct Record *record)
+{
+	char **binaries;
+	size_t size;
+
+	(void)record;
+	const int ret = libalts_load_available_binaries(&binaries, &size);
+	if (ret == 0) {
+		for (size_t i=0; i<size; i++)
+			free(binaries[i]);
+		free(binaries);
+	}
+	return ret;
+}
+
+static int loadBinaryPriorities(const struct Record *record)
+{
+	int *priorities;
+	size_t size;
+
+	const int ret = libalts_load_binary_priorities(record->binary_name, &priorities, &size);
+	free(priorities);
+	return ret;
+}
+
+static int readPriorityFromFile(const struct Record *record)
+{
+	return libalts_read_binary_configured_priority_from_file(record->binary_name, override_path);
+}
+
+static int writePriorityToFile(const struct Record *record)
+{
+	return libalts_write_binary_configured_priority_to_file(record->binary_name, record->argument, override_path);
+}
+
+static int readConfiguredPriority(const struct Record *record)
+{
+	return libalts_read_configured_priority(record->binary_name, NULL);
+}
+
+// also replays executions, which are captured with 0 or -1 as well
+static int resolveDefaultBinary(const struct Record *record)
+{
+	char *target;
+	int options;
+
+	const int ret = libalts_resolve_default_binary(record->binary_name, &target, &options);
+	if (ret == 0)
+		free(target);
+	return ret;
+}
+
+static int getDefaultManpages(const struct Record *record)
+{
+	char **manpages = libalts_get_default_manpages(record->binary_name);
+	int count = 0;
+
+	for (char **p = manpages; p != NULL && *p != NULL; p++, count++)
+		free(*p);
+	free(manpages);
+	return count;
+}
+
+static int getGeneration(const struct Record *record)
+{
+	unsigned long long generation;
+
+	(void)record;
+	return libalts_get_generation(&generation);
+}
+
+static int skip(const struct Record *record)
+{
+	(void)record;
+	return SKIPPED;
+}
+
+// as named by capture.c
+static const struct
+{
+	const char *name;
+	int (*replay)(const struct Record *record);
+} functions[LIBALTS_STATS_FUNCTION_COUNT] = {
+	[LIBALTS_STATS_LOAD_HIGHEST_PRIORITY] = {"load_highest_priority_binary_alternatives", loadHighest},
+	[LIBALTS_STATS_LOAD_EXACT_PRIORITY] = {"load_exact_priority_binary_alternatives", loadExact},
+	[LIBALTS_STATS_LOAD_AVAILABLE_BINARIES] = {"load_available_binaries", loadAvailableBinaries},
+	[LIBALTS_STATS_LOAD_BINARY_PRIORITIES] = {"load_binary_priorities", loadBinaryPriorities},
+	[LIBALTS_STATS_READ_PRIORITY_FROM_FILE] = {"read_binary_configured_priority_from_file", readPriorityFromFile},
+	[LIBALTS_STATS_WRITE_PRIORITY_TO_FILE] = {"write_binary_configured_priority_to_file", writePriorityToFile},
+	[LIBALTS_STATS_READ_CONFIGURED_PRIORITY] = {"read_configured_priority", readConfiguredPriority},
+	[LIBALTS_STATS_EXEC_DEFAULT] = {"exec_default", resolveDefaultBinary},
+	[LIBALTS_STATS_RESOLVE_DEFAULT_BINARY] = {"resolve_default_binary", resolveDefaultBinary},
+	[LIBALTS_STATS_GET_DEFAULT_MANPAGES] = {"get_default_manpages", getDefaultManpages},
+	[LIBALTS_STATS_GET_GENERATION] = {"get_generation", getGeneration},
+	[LIBALTS_STATS_EXPORT_INHERITED_CACHE] = {"export_inherited_cache", skip},
+	[LIBALTS_STATS_GENERATE_LAUNCHER] = {"generate_launcher", skip},
+};
+
+static int findFunction(const char *name)
+{
+	for (int i=0; i<LIBALTS_STATS_FUNCTION_COUNT; i++) {
+		if (strcmp(functions[i].name, name) == 0)
+			return i;
+	}
+	return -1;
+}
+
+// returns number of records loaded, or -1 on error
+static int loadRecords(const char *capture_path)
+{
+	FILE *f = fopen(capture_path, "r");
+	char line[512];
+	size_t allocated = 0;
+	int line_number = 0, ret = -1;
+
+	if (f == NULL) {
+		perror(capture_path);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		char *fields = line, *name, *binary_name, *argument, *result;
+		struct Record record;
+
+		line_number++;
+		name = strsep(&fields, "\t");
+		binary_name = strsep(&fields, "\t");
+		argument = strsep(&fields, "\t");
+		result = strsep(&fields, "\n");
+		if (result == NULL || (record.function = findFunction(name)) < 0) {
+			fprintf(stderr, "%s:%d: not a captured call\n", capture_path, line_number);
+			goto err;
+		}
+		record.argument = atoi(argument);
+		record.result = atoi(result);
+
+		if (n_records == allocated) {
+			allocated = 2 * allocated + 64;
+			struct Record *tmp = realloc(records, allocated * sizeof(struct Record));
+			if (tmp == NULL)
+				goto err;
+			records = tmp;
+		}
+		if ((record.binary_name = strdup(binary_name)) == NULL)
+			goto err;
+		records[n_records++] = record;
+	}
+	ret = ferror(f) ? -1 : 0;
+
+err:
+	fclose(f);
+	return ret;
+}
+
+static int copyOverride(const char *source_path)
+{
+	char buffer[4096];
+	size_t len;
+	int ret = 0;
+
+	FILE *source = fopen(source_path, "r");
+	FILE *copy = fopen(override_path, "w");
+	if (source == NULL || copy == NULL) {
+		perror(source == NULL ? source_path : override_path);
+		ret = -1;
+		goto err;
+	}
+	while ((len = fread(buffer, 1, sizeof(buffer), source)) > 0) {
+		if (fwrite(buffer, 1, len, copy) != len)
+			ret = -1;
+	}
+	if (ferror(source))
+		ret = -1;
+
+err:
+	if (source != NULL)
+		fclose(source);
+	if (copy != NULL && fclose(copy) != 0)
+		ret = -1;
+	return ret;
+}
+
+static void* mapShared(size_t size)
+{
+	void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	return map != MAP_FAILED ? map : NULL;
+}
+
+static void waitFor(pid_t pid)
+{
+	while (waitpid(pid, NULL, 0) < 0 && errno == EINTR)
+		;
+}
+
+static void runWorker(int worker, int start_fd, struct FunctionStats *stats)
+{
+	char c;
+
+	// released together when the parent closes the pipe
+	while (read(start_fd, &c, 1) < 0 && errno == EINTR)
+		;
+	close(start_fd);
+
+	for (int pass=0; pass<passes; pass++) {
+		for (size_t i=worker; i<n_records; i+=workers) {
+			const struct Record *record = records + i;
+			struct FunctionStats *function_stats = stats + record->function;
+			struct timespec start, end;
+
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			const int result = functions[record->function].replay(record);
+			clock_gettime(CLOCK_MONOTONIC, &end);
+
+			if (result == SKIPPED) {
+				function_stats->skipped++;
+				continue;
+			}
+			function_stats->calls++;
+			function_stats->ns += (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
+			if (result != record->result)
+				function_stats->changed++;
+		}
+	}
+	_exit(0);
+}
+
+// returns 0 and the summed statistics of all workers, -1 on error
+static int runWorkers(struct FunctionStats *total, double *seconds)
+{
+	const size_t stats_size = (size_t)workers * LIBALTS_STATS_FUNCTION_COUNT * sizeof(struct FunctionStats);
+	struct FunctionStats *stats = mapShared(stats_size);
+	pid_t *pids = calloc(workers, sizeof(pid_t));
+	int start_pipe[2] = { -1, -1 };
+	int started = 0, ret = -1;
+	struct timespec start, end;
+
+	if (stats == NULL || pids == NULL || pipe(start_pipe) < 0) {
+		perror("Cannot prepare the workers");
+		goto err;
+	}
+
+	fflush(stdout);
+	for (; started < workers; started++) {
+		pids[started] = fork();
+		if (pids[started] < 0)
+			break;
+		if (pids[started] == 0) {
+			close(start_pipe[1]);
+			runWorker(started, start_pipe[0], stats + (size_t)started * LIBALTS_STATS_FUNCTION_COUNT);
+		}
+	}
+
+	close(start_pipe[0]);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	close(start_pipe[1]);
+	for (int i=0; i<started; i++)
+		waitFor(pids[i]);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (started < workers) {
+		perror("Cannot start the workers");
+		goto err;
+	}
+
+	memset(total, 0, LIBALTS_STATS_FUNCTION_COUNT * sizeof(struct FunctionStats));
+	for (int w=0; w<workers; w++) {
+		for (int f=0; f<LIBALTS_STATS_FUNCTION_COUNT; f++) {
+			const struct FunctionStats *worker_stats = stats + (size_t)w * LIBALTS_STATS_FUNCTION_COUNT + f;
+			total[f].calls += worker_stats->calls;
+			total[f].changed += worker_stats->changed;
+			total[f].skipped += worker_stats->skipped;
+			total[f].ns += worker_stats->ns;
+		}
+	}
+	*seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	ret = 0;
+
+err:
+	free(pids);
+	if (stats != NULL)
+		munmap(stats, stats_size);
+	return ret;
+}
+
+static void printHelp()
+{
+	puts("alts-replay -d config_dir [-u override] [-j workers] [-n passes] capture_file\n"
+	     "    -d -- configuration directory to resolve in\n"
+	     "    -u -- user override the replay starts from, it is copied (none)\n"
+	     "    -j -- worker processes issuing the calls concurrently (1)\n"
+	     "    -n -- times each worker issues its share of the calls (1)");
+}
+
+int main(int argc, char *argv[])
+{
+	struct FunctionStats total[LIBALTS_STATS_FUNCTION_COUNT];
+	const char *config_dir = NULL, *source_override = NULL;
+	unsigned long calls = 0, changed = 0, skipped = 0;
+	double seconds;
+	int opt, fd, ret = 1;
+
+	while ((opt = getopt(argc, argv, "d:u:j:n:h")) != -1) {
+		switch (opt) {
+			case 'd':
+				config_dir = optarg;
+				break;
+			case 'u':
+				source_override = optarg;
+				break;
+			case 'j':
+				workers = atoi(optarg);
+				break;
+			case 'n':
+				passes = atoi(optarg);
+				break;
+			default:
+				printHelp();
+				return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (config_dir == NULL || optind != argc - 1 || workers < 1 || passes < 1) {
+		printHelp();
+		return 1;
+	}
+
+	// the replay itself is not captured, nor resolved from a cache
+	unsetenv("LIBALTERNATIVES_CAPTURE");
+	unsetenv("LIBALTERNATIVES_CACHE");
+	unsetenv("LIBALTERNATIVES_TRACE");
+
+	if (loadRecords(argv[optind]) < 0)
+		return 1;
+	if (n_records == 0) {
+		fprintf(stderr, "No calls captured in %s\n", argv[optind]);
+		return 1;
+	}
+
+	if ((fd = mkstemp(override_path)) < 0) {
+		perror("Cannot create the scratch override");
+		return 1;
+	}
+	close(fd);
+	if (source_override != NULL && copyOverride(source_override) < 0)
+		goto err;
+
+	setConfigDirectory(config_dir);
+	setConfigPath(override_path);
+	if (runWorkers(total, &seconds) < 0)
+		goto err;
+
+	printf("%-42s %10s %10s %10s\n", "function", "calls", "mean_us", "changed");
+	for (int f=0; f<LIBALTS_STATS_FUNCTION_COUNT; f++) {
+		calls += total[f].calls;
+		changed += total[f].changed;
+		skipped += total[f].skipped;
+		if (total[f].calls == 0)
+			continue;
+		printf("%-42s %10lu %10.1f %10lu\n", functions[f].name, total[f].calls,
+		       total[f].ns / 1e3 / total[f].calls, total[f].changed);
+	}
+	printf("%-42s %10lu %10s %10lu\n", "total", calls, "", changed);
+	printf("\n%d workers: %.0f calls/s, %lu calls skipped\n", workers, calls / seconds, skipped);
+	ret = 0;
+
+err:
+	unlink(override_path);
+	for (size_t i=0; i<n_records; i++)
+		free(records[i].binary_name);
+	free(records);
+	return ret;
+}
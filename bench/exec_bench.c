@@ -0,0 +1,438 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Fork to exit latency of a process started through alts, through
+ * update-alternatives style symlinks and directly.
+ *
+ * The target is test/argv_replaced_helper, which exits at once, and with
+ * 0 only if argv[0] ends with its name, so every spawn is checked to
+ * have reached it. alts is linked to a copy of the shared library that
+ * resolves in CONFIG_DIR of the build directory, where alternatives of
+ * priority 10 and 20 are written. The update-alternatives case
+ * follows two symlinks, like /usr/bin/name -> /etc/alternatives/name ->
+ * target. Each spawn is timed from before fork() until waitpid()
+ * returns, and the cases take turns, so that drift of the machine
+ * affects all of them alike.
+ *
+ * With -c, a storm of that many launcher processes is released at once
+ * instead, each spawning the target through alts in a loop, like a
+ * parallel build starting its compilers. With -W, it runs a second time
+ * while a writer process toggles the user override between two
+ * priorities with libalts_write_binary_configured_priority_to_file(),
+ * so that launchers race with the replaced override file. Percentiles are over the spawns of all launchers.
+ */
+
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/libalternatives.h"
+
+#define TARGET_NAME "argv_replaced_helper"
+#define CASE_COUNT 3
+
+struct ExecCase
+{
+	const char *name;
+	char path[PATH_MAX];
+	double *samples;
+	int failures;
+};
+
+// shared by the storm processes
+struct StormState
+{
+	int stop;
+	int failures;
+	unsigned long writes;
+	unsigned long write_failures;
+};
+
+static char tree_path[] = "/tmp/libalternatives_exec_XXXXXX";
+static int iterations = 2000, warmup = 100;
+static int launchers = 0, write_interval = -1;
+
+static double elapsedMicroseconds(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+	const double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+// returns microseconds from fork() until the exited child is reaped,
+// or -1 if it did not reach the target
+static double spawnAndWait(const char *path)
+{
+	char *argv[] = { (char*)path, TARGET_NAME, NULL };
+	struct timespec start, end;
+	int status;
+	pid_t pid;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pid = fork();
+	if (pid < 0)
+		return -1;
+	if (pid == 0) {
+		execv(path, argv);
+		_exit(127);
+	}
+
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR)
+			return -1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		return -1;
+	return elapsedMicroseconds(&start, &end);
+}
+
+static int writeConfig()
+{
+	FILE *file;
+	int ret = 0;
+
+	if ((mkdir(CONFIG_DIR, 0755) < 0 && errno != EEXIST) ||
+	    (mkdir(CONFIG_DIR "/" TARGET_NAME, 0755) < 0 && errno != EEXIST))
+		return -1;
+
+	// two priorities for the writer to toggle between
+	for (int prio = 10; prio <= 20 && ret == 0; prio += 10) {
+		char path[PATH_MAX];
+
+		snprintf(path, sizeof(path), CONFIG_DIR "/" TARGET_NAME "/%d.conf", prio);
+		file = fopen(path, "w");
+		if (file == NULL)
+			return -1;
+		if (fputs("binary=" HELPER_PATH "\n", file) < 0)
+			ret = -1;
+		if (fclose(file) != 0)
+			ret = -1;
+	}
+	return ret;
+}
+
+static void removeConfig()
+{
+	unlink(CONFIG_DIR "/" TARGET_NAME "/10.conf");
+	unlink(CONFIG_DIR "/" TARGET_NAME "/20.conf");
+	rmdir(CONFIG_DIR "/" TARGET_NAME);
+	rmdir(CONFIG_DIR);
+}
+
+// links tree_path/dir/name to target
+static int linkIn(const char *dir, const char *target, char *link_path)
+{
+	snprintf(link_path, PATH_MAX, "%s/%s", tree_path, dir);
+	if (mkdir(link_path, 0755) < 0)
+		return -1;
+	snprintf(link_path, PATH_MAX, "%s/%s/" TARGET_NAME, tree_path, dir);
+	return symlink(target, link_path);
+}
+
+static void removeTree()
+{
+	static const char *dirs[] = { "alternatives", "bin", "alts" };
+	char path[PATH_MAX];
+
+	unlink(libalts_get_user_config_path());
+	for (size_t i = 0; i < sizeof(dirs)/sizeof(*dirs); i++) {
+		snprintf(path, sizeof(path), "%s/%s/" TARGET_NAME, tree_path, dirs[i]);
+		unlink(path);
+		snprintf(path, sizeof(path), "%s/%s", tree_path, dirs[i]);
+		rmdir(path);
+	}
+	rmdir(tree_path);
+}
+
+static double percentile(const double *sorted, int n, double p)
+{
+	int i = (int)(n * p / 100);
+	return sorted[i < n ? i : n - 1];
+}
+
+// times every case in turns and prints their percentiles
+static int runCases(struct ExecCase *cases)
+{
+	for (int i = 0; i < CASE_COUNT; i++) {
+		cases[i].samples = malloc(iterations * sizeof(double));
+		if (cases[i].samples == NULL) {
+			perror("Cannot allocate samples");
+			return -1;
+		}
+	}
+
+	for (int i = 0; i < warmup; i++) {
+		for (int c = 0; c < CASE_COUNT; c++)
+			spawnAndWait(cases[c].path);
+	}
+
+	for (int i = 0; i < iterations; i++) {
+		for (int c = 0; c < CASE_COUNT; c++) {
+			const double us = spawnAndWait(cases[c].path);
+			if (us < 0)
+				cases[c].failures++;
+			cases[c].samples[i] = us;
+		}
+	}
+
+	printf("%-12s %10s %10s\n", "case", "median us", "p99 us");
+	for (int c = 0; c < CASE_COUNT; c++) {
+		if (cases[c].failures > 0) {
+			fprintf(stderr, "%s: %d of %d spawns did not reach %s\n",
+			        cases[c].name, cases[c].failures, iterations, HELPER_PATH);
+			return -1;
+		}
+		qsort(cases[c].samples, iterations, sizeof(double), compareDouble);
+		printf("%-12s %10.1f %10.1f\n", cases[c].name,
+		       percentile(cases[c].samples, iterations, 50),
+		       percentile(cases[c].samples, iterations, 99));
+	}
+
+	printf("alts adds %.1f us median and %.1f us p99 per spawn over direct exec\n",
+	       percentile(cases[2].samples, iterations, 50) - percentile(cases[0].samples, iterations, 50),
+	       percentile(cases[2].samples, iterations, 99) - percentile(cases[0].samples, iterations, 99));
+	return 0;
+}
+
+static void* mapShared(size_t size)
+{
+	void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	return map != MAP_FAILED ? map : NULL;
+}
+
+static void waitFor(pid_t pid)
+{
+	while (waitpid(pid, NULL, 0) < 0 && errno == EINTR)
+		;
+}
+
+static void runWriter(struct StormState *state)
+{
+	const char *override_path = libalts_get_user_config_path();
+
+	for (int i = 0; !__atomic_load_n(&state->stop, __ATOMIC_RELAXED); i++) {
+		if (libalts_write_binary_configured_priority_to_file(TARGET_NAME, i % 2 ? 20 : 10, override_path) == 0)
+			__atomic_fetch_add(&state->writes, 1, __ATOMIC_RELAXED);
+		else
+			__atomic_fetch_add(&state->write_failures, 1, __ATOMIC_RELAXED);
+		if (write_interval > 0)
+			usleep(write_interval);
+	}
+	_exit(0);
+}
+
+static void runLauncher(const char *path, int start_fd, double *samples, struct StormState *state)
+{
+	char c;
+
+	// released together when the parent closes the pipe
+	while (read(start_fd, &c, 1) < 0 && errno == EINTR)
+		;
+	close(start_fd);
+
+	for (int i = 0; i < iterations; i++) {
+		samples[i] = spawnAndWait(path);
+		if (samples[i] < 0)
+			__atomic_fetch_add(&state->failures, 1, __ATOMIC_RELAXED);
+	}
+	_exit(0);
+}
+
+// releases all launchers at once and prints the percentiles of their
+// spawns, with or without a concurrent override writer
+static int runStorm(const char *path, int with_writer)
+{
+	const size_t n = (size_t)launchers * iterations;
+	double *samples = mapShared(n * sizeof(double));
+	struct StormState *state = mapShared(sizeof(struct StormState));
+	pid_t *pids = calloc(launchers, sizeof(pid_t));
+	pid_t writer = -1;
+	int start_pipe[2] = { -1, -1 };
+	int started = 0, ret = -1;
+	struct timespec start, end;
+
+	if (samples == NULL || state == NULL || pids == NULL || pipe(start_pipe) < 0) {
+		perror("Cannot prepare the storm");
+		goto err;
+	}
+
+	fflush(stdout);
+	for (; started < launchers; started++) {
+		pids[started] = fork();
+		if (pids[started] < 0)
+			break;
+		if (pids[started] == 0) {
+			close(start_pipe[1]);
+			runLauncher(path, start_pipe[0], samples + (size_t)started * iterations, state);
+		}
+	}
+	if (started == launchers && with_writer) {
+		writer = fork();
+		if (writer == 0) {
+			// launchers are only released once all write ends are closed
+			close(start_pipe[0]);
+			close(start_pipe[1]);
+			runWriter(state);
+		}
+	}
+
+	close(start_pipe[0]);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	close(start_pipe[1]);
+	for (int i = 0; i < started; i++)
+		waitFor(pids[i]);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	__atomic_store_n(&state->stop, 1, __ATOMIC_RELAXED);
+	if (writer > 0)
+		waitFor(writer);
+
+	if (started < launchers || (with_writer && writer < 0)) {
+		perror("Cannot start the storm");
+		goto err;
+	}
+
+	// failed spawns sort first and are left out
+	qsort(samples, n, sizeof(double), compareDouble);
+	const int failures = state->failures;
+	const double *succeeded = samples + failures;
+	const int count = n - failures;
+
+	printf("%-8s %10.0f", with_writer ? "toggling" : "none", count / (elapsedMicroseconds(&start, &end) / 1e6));
+	if (count > 0) {
+		printf(" %8.1f %8.1f %8.1f %8.1f %8.1f",
+		       percentile(succeeded, count, 50), percentile(succeeded, count, 90),
+		       percentile(succeeded, count, 99), percentile(succeeded, count, 99.9),
+		       succeeded[count - 1]);
+	}
+	printf(" %8d %8lu %8lu\n", failures, state->writes, state->write_failures);
+	ret = 0;
+
+err:
+	free(pids);
+	if (state != NULL)
+		munmap(state, sizeof(struct StormState));
+	if (samples != NULL)
+		munmap(samples, n * sizeof(double));
+	return ret;
+}
+
+static void printHelp()
+{
+	puts("exec_bench [-i iterations] [-w warmup] [-c launchers [-W interval]]\n"
+	     "    -i -- timed spawns per case or launcher (2000)\n"
+	     "    -w -- untimed spawns per case before (100)\n"
+	     "    -c -- concurrent launchers spawning through alts\n"
+	     "    -W -- repeat the storm toggling the override every interval us, 0 back to back");
+}
+
+int main(int argc, char *argv[])
+{
+	struct ExecCase cases[CASE_COUNT] = {
+		{ .name = "direct exec" },
+		{ .name = "symlinks" },
+		{ .name = "alts" },
+	};
+	char alternatives_link[PATH_MAX];
+	int opt, ret = 1;
+
+	while ((opt = getopt(argc, argv, "i:w:c:W:h")) != -1) {
+		switch (opt) {
+			case 'i':
+				iterations = atoi(optarg);
+				break;
+			case 'w':
+				warmup = atoi(optarg);
+				break;
+			case 'c':
+				launchers = atoi(optarg);
+				break;
+			case 'W':
+				write_interval = atoi(optarg);
+				break;
+			default:
+				printHelp();
+				return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (iterations < 1 || warmup < 0 || launchers < 0 || (write_interval >= 0 && launchers == 0)) {
+		printHelp();
+		return 1;
+	}
+
+	if (mkdtemp(tree_path) == NULL) {
+		perror("Cannot create link directory");
+		return 1;
+	}
+
+	// no user override, until the writer writes one into the link
+	// directory, and no inherited cache or tracing
+	setenv("XDG_CONFIG_HOME", tree_path, 1);
+	unsetenv("LIBALTERNATIVES_CACHE");
+	unsetenv("LIBALTERNATIVES_TRACE");
+
+	snprintf(cases[0].path, sizeof(cases[0].path), "%s", HELPER_PATH);
+	if (linkIn("alternatives", HELPER_PATH, alternatives_link) < 0 ||
+	    linkIn("bin", alternatives_link, cases[1].path) < 0 ||
+	    linkIn("alts", ALTS_PATH, cases[2].path) < 0) {
+		perror("Cannot create links");
+		goto err;
+	}
+	if (writeConfig() < 0) {
+		perror("Cannot write " CONFIG_DIR);
+		goto err;
+	}
+
+	if (launchers == 0) {
+		if (runCases(cases) < 0)
+			goto err;
+	} else {
+		for (int i = 0; i < warmup; i++)
+			spawnAndWait(cases[2].path);
+
+		printf("%d launchers with %d spawns each through alts, times in us\n", launchers, iterations);
+		printf("%-8s %10s %8s %8s %8s %8s %8s %8s %8s %8s\n", "writer", "spawns/s",
+		       "p50", "p90", "p99", "p99.9", "max", "failed", "writes", "wfailed");
+		if (runStorm(cases[2].path, 0) < 0 ||
+		    (write_interval >= 0 && runStorm(cases[2].path, 1) < 0))
+			goto err;
+	}
+	ret = 0;
+
+err:
+	for (int i = 0; i < CASE_COUNT; i++)
+		free(cases[i].samples);
+	removeConfig();
+	removeTree();
+	return ret;
+}
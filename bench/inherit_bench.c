@@ -0,0 +1,321 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Synthetic recursive-make workload for the inherited resolution cache.
+ *
+ * A tree of "make" processes, depth levels deep with fanout sub-makes
+ * each, where every leaf spawns jobs "compiler" processes that go through
+ * libalts_exec_default("cc"). The tree is run with LIBALTERNATIVES_CACHE
+ * unset and with the cache filled at the top, as `alts --inherit cc` does.
+ *
+ * Process creation dominates the workload, so the resolution itself,
+ * the part that is replaced by the cache, is also timed on its own.
+ */
+
+#define _GNU_SOURCE
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/libalternatives.h"
+#include "../src/internal.h"
+
+extern void setConfigDirectory(const char *);
+
+static char tree_path[] = "/tmp/libalternatives_bench_XXXXXX";
+static int depth = 2, fanout = 4, jobs = 32, runs = 5;
+
+static int writeTreeFile(const char *name, const char *content)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", tree_path, name);
+
+	FILE *f = fopen(path, "w");
+	if (f == NULL)
+		return -1;
+	fputs(content, f);
+	return fclose(f);
+}
+
+// cache entries of directories changed in the last second are not
+// exported, so the fixtures are moved to the past
+static void setTreeTime(const char *name)
+{
+	char path[512];
+	struct timespec times[2] = {{1000000, 0}, {1000000, 0}};
+
+	snprintf(path, sizeof(path), "%s/%s", tree_path, name);
+	utimensat(AT_FDCWD, path, times, 0);
+}
+
+static int createTree()
+{
+	char name[64], content[128];
+
+	if (mkdtemp(tree_path) == NULL)
+		return -1;
+
+	if (mkdir(strcat(strcpy(name, tree_path), "/cc"), 0755) < 0)
+		return -1;
+
+	for (int prio=10; prio<=100; prio+=10) {
+		snprintf(name, sizeof(name), "cc/%d.conf", prio);
+		snprintf(content, sizeof(content), "binary=/bin/true\nman=cc-%d.1,gcc-%d.1\ngroup=cc,c++,cpp\n", prio, prio);
+		if (writeTreeFile(name, content) < 0)
+			return -1;
+	}
+
+	// user override file that does not mention cc, so it is read in full
+	FILE *f = fopen(strcat(strcpy(name, tree_path), "/libalternatives.conf"), "w");
+	if (f == NULL)
+		return -1;
+	for (int i=0; i<60; i++)
+		fprintf(f, "program%d=%d\n", i, i + 10);
+	fclose(f);
+
+	setTreeTime("cc");
+	setTreeTime("libalternatives.conf");
+	setTreeTime("");
+
+	setenv("XDG_CONFIG_HOME", tree_path, 1);
+	setConfigDirectory(tree_path);
+	return 0;
+}
+
+static int removeTreeEntry(const char *path, __attribute__((unused)) const struct stat *st, __attribute__((unused)) int flag, __attribute__((unused)) struct FTW *ftw)
+{
+	return remove(path);
+}
+
+static int waitChild(pid_t pid)
+{
+	int status;
+
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR)
+			return -1;
+	}
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+static int runCompiler()
+{
+	char *argv[] = { "cc", "-c", "file.c", NULL };
+	pid_t pid = fork();
+
+	if (pid == 0) {
+		libalts_exec_default(argv);
+		_exit(127);
+	}
+
+	return pid < 0 ? -1 : waitChild(pid);
+}
+
+// returns number of failed compiler or make processes
+static int runMake(int level)
+{
+	int failed = 0;
+
+	if (level == 0) {
+		for (int i=0; i<jobs; i++)
+			failed += runCompiler() != 0;
+		return failed;
+	}
+
+	for (int i=0; i<fanout; i++) {
+		pid_t pid = fork();
+
+		if (pid == 0)
+			_exit(runMake(level - 1) == 0 ? 0 : 1);
+		failed += pid < 0 || waitChild(pid) != 0;
+	}
+
+	return failed;
+}
+
+static double elapsedSeconds(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+	const double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+// returns median microseconds per compiler process, or -1 on failure
+static double runWorkload(int is_cached)
+{
+	double results[runs];
+	int compilers = jobs;
+
+	for (int i=0; i<depth; i++)
+		compilers *= fanout;
+
+	for (int run=0; run<runs; run++) {
+		struct timespec start, end;
+		pid_t pid;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		pid = fork();
+		if (pid == 0) {
+			// top level make that fills the cache for the whole tree
+			if (is_cached) {
+				setenv("LIBALTERNATIVES_CACHE", "", 1);
+				if (libalts_export_inherited_cache("cc") != 0)
+					_exit(1);
+			}
+			else {
+				unsetenv("LIBALTERNATIVES_CACHE");
+			}
+			_exit(runMake(depth) == 0 ? 0 : 1);
+		}
+		if (pid < 0 || waitChild(pid) != 0)
+			return -1;
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		results[run] = elapsedSeconds(&start, &end) * 1e6 / compilers;
+	}
+
+	qsort(results, runs, sizeof(double), compareDouble);
+	return results[runs / 2];
+}
+
+// returns median nanoseconds of resolving cc in this process, or -1
+static double runResolution(int is_cached)
+{
+	const int iterations = 10000;
+	const struct InheritPaths paths = {
+		.config_dir = tree_path,
+		.system_config = libalts_get_system_config_path(),
+		.user_config = libalts_get_user_config_path(),
+	};
+	double results[runs];
+
+	if (is_cached) {
+		setenv("LIBALTERNATIVES_CACHE", "", 1);
+		if (libalts_export_inherited_cache("cc") != 0)
+			return -1;
+	}
+
+	for (int run=0; run<runs; run++) {
+		struct timespec start, end;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i=0; i<iterations; i++) {
+			struct AlternativeLink *alts = NULL;
+			char *target = NULL;
+			int options;
+
+			if (is_cached) {
+				if (lookupInheritedCache(&paths, "cc", &target, &options) != 0)
+					return -1;
+				free(target);
+			}
+			else {
+				libalts_read_configured_priority("cc", NULL);
+				if (libalts_load_highest_priority_binary_alternatives("cc", &alts) != 0)
+					return -1;
+				libalts_free_alternatives_ptr(&alts);
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		results[run] = elapsedSeconds(&start, &end) * 1e9 / iterations;
+	}
+
+	unsetenv("LIBALTERNATIVES_CACHE");
+	qsort(results, runs, sizeof(double), compareDouble);
+	return results[runs / 2];
+}
+
+static void printHelp()
+{
+	puts("inherit_bench [-d depth] [-f fanout] [-j jobs] [-r runs]\n"
+	     "    -d -- levels of recursive make (2)\n"
+	     "    -f -- sub-makes per make (4)\n"
+	     "    -j -- compiler processes per leaf make (32)\n"
+	     "    -r -- runs per mode, median is reported (5)");
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+	double uncached, cached, uncached_resolution, cached_resolution;
+
+	while ((opt = getopt(argc, argv, "d:f:j:r:h")) != -1) {
+		switch (opt) {
+			case 'd':
+				depth = atoi(optarg);
+				break;
+			case 'f':
+				fanout = atoi(optarg);
+				break;
+			case 'j':
+				jobs = atoi(optarg);
+				break;
+			case 'r':
+				runs = atoi(optarg);
+				break;
+			default:
+				printHelp();
+				return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (depth < 0 || fanout < 1 || jobs < 1 || runs < 1) {
+		printHelp();
+		return 1;
+	}
+
+	if (createTree() < 0) {
+		perror("Cannot create configuration tree");
+		return 1;
+	}
+
+	// warm up page cache and dentries for both modes
+	runWorkload(0);
+	uncached = runWorkload(0);
+	cached = runWorkload(1);
+	uncached_resolution = runResolution(0);
+	cached_resolution = runResolution(1);
+
+	nftw(tree_path, removeTreeEntry, 8, FTW_DEPTH | FTW_PHYS);
+
+	if (uncached < 0 || cached < 0 || uncached_resolution < 0 || cached_resolution < 0) {
+		fputs("Workload failed\n", stderr);
+		return 1;
+	}
+
+	printf("spawn uncached:      %8.1f us per compiler\n", uncached);
+	printf("spawn cached:        %8.1f us per compiler\n", cached);
+	printf("spawn speedup:       %8.2fx\n", uncached / cached);
+	printf("resolution uncached: %8.1f ns\n", uncached_resolution);
+	printf("resolution cached:   %8.1f ns\n", cached_resolution);
+	printf("resolution speedup:  %8.2fx\n", uncached_resolution / cached_resolution);
+	return 0;
+}
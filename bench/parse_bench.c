@@ -0,0 +1,117 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Lookup and parse time of the installed libalternatives.so over its
+ * configured CONFIG_DIR, to compare builds with and without ENABLE_LTO
+ * and ENABLE_PGO. Both builds should be configured with the same
+ * CONFIG_DIR, eg. one of the test trees.
+ */
+
+#define _GNU_SOURCE
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/libalternatives.h"
+
+static int iterations = 2000, runs = 5;
+
+static double elapsedSeconds(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+	const double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+// what alts does to execute and to list a binary
+static void lookupBinary(const char *binary_name)
+{
+	struct AlternativeLink *alts = NULL;
+	int *priorities = NULL;
+	size_t size;
+
+	libalts_read_configured_priority(binary_name, NULL);
+	if (libalts_load_highest_priority_binary_alternatives(binary_name, &alts) == 0)
+		libalts_free_alternatives_ptr(&alts);
+	if (libalts_load_binary_priorities(binary_name, &priorities, &size) == 0)
+		free(priorities);
+}
+
+static void printHelp()
+{
+	puts("parse_bench [-i iterations] [-r runs]\n"
+	     "    -i -- lookups of every binary per run (2000)\n"
+	     "    -r -- runs, median is reported (5)");
+}
+
+int main(int argc, char *argv[])
+{
+	char **binaries = NULL;
+	size_t count = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "i:r:h")) != -1) {
+		switch (opt) {
+			case 'i':
+				iterations = atoi(optarg);
+				break;
+			case 'r':
+				runs = atoi(optarg);
+				break;
+			default:
+				printHelp();
+				return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (iterations < 1 || runs < 1) {
+		printHelp();
+		return 1;
+	}
+
+	if (libalts_load_available_binaries(&binaries, &count) != 0 || count == 0) {
+		fputs("No alternatives in CONFIG_DIR " CONFIG_DIR "\n", stderr);
+		return 1;
+	}
+
+	double results[runs];
+	for (int run=0; run<runs; run++) {
+		struct timespec start, end;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i=0; i<iterations; i++) {
+			for (size_t j=0; j<count; j++)
+				lookupBinary(binaries[j]);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		results[run] = elapsedSeconds(&start, &end) * 1e9 / (iterations * count);
+	}
+	qsort(results, runs, sizeof(double), compareDouble);
+
+	for (size_t j=0; j<count; j++)
+		free(binaries[j]);
+	free(binaries);
+
+	printf("binaries:          %8zu\n", count);
+	printf("lookup and parse:  %8.1f ns per binary\n", results[runs / 2]);
+	return 0;
+}
@@ -0,0 +1,207 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Throughput of the options and override parsers in memory, without
+ * any file system access, in MB of input per second.
+ *
+ * The options are a synthetic file of binary, man and group lines,
+ * parsed at once into one allocation, as the library does, and with a
+ * parser state whole and in 1 KiB reads. The override has
+ * K entries of other binaries; it is parsed for a binary it does not
+ * hold, the worst case of a lookup, and updated for one, as alts -s does.
+ */
+
+#define _GNU_SOURCE
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/libalternatives.h"
+#include "../src/parser.h"
+
+static double megabytes = 16;
+static int entries = 200, runs = 5;
+
+static double elapsedSeconds(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+	const double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static char* generateOptions(size_t *size)
+{
+	char *data = NULL;
+	size_t len = 0;
+	FILE *out = open_memstream(&data, &len);
+
+	if (out == NULL)
+		return NULL;
+	fputs("binary = /usr/bin/editor-with-a-rather-long-name\n", out);
+	for (int i=0; i<entries; i++)
+		fprintf(out, "man = editor%d.1, editor-tool%d.1 ,editor-helper%d.8\n", i, i, i);
+	fputs("group = editor, editor-tool, editor-helper\noptions = KeepArgv0\n", out);
+	fclose(out);
+
+	*size = len;
+	return data;
+}
+
+static char* generateOverride(size_t *size)
+{
+	char *data = NULL;
+	size_t len = 0;
+	FILE *out = open_memstream(&data, &len);
+
+	if (out == NULL)
+		return NULL;
+	fputs("# user overrides\n", out);
+	for (int i=0; i<entries; i++)
+		fprintf(out, "binary%d = %d # set by alts -s\n", i, 10 + i % 90);
+	fclose(out);
+
+	*size = len;
+	return data;
+}
+
+static void parseOptionsAtOnce(const char *data, size_t size)
+{
+	struct AlternativeLink *links;
+
+	if (parseOptionsBuffer(data, size, 10, &links) == 0)
+		free(links);
+}
+
+static void parseOptionsWhole(const char *data, size_t size)
+{
+	struct OptionsParserState *state = initOptionsParser();
+
+	parseOptionsData(data, size, state);
+	free(doneOptionsParser(10, state));
+}
+
+static void parseOptionsInReads(const char *data, size_t size)
+{
+	struct OptionsParserState *state = initOptionsParser();
+
+	for (size_t pos=0; pos<size; pos+=1024) {
+		if (parseOptionsData(data + pos, size - pos < 1024 ? size - pos : 1024, state) < 0)
+			break;
+	}
+	free(doneOptionsParser(10, state));
+}
+
+static void parseOverrideMiss(const char *data, size_t size)
+{
+	struct ConfigParserState *state = initConfigParser("editor");
+
+	(void)size;
+	parseConfigData(data, state);
+	doneConfigParser(state);
+}
+
+static void updateOverride(const char *data, size_t size)
+{
+	struct ConfigParserState *state = initConfigParser("binary0");
+
+	(void)size;
+	parseConfigData(data, state);
+	setBinaryPriorityAndReturnUpdatedConfig(50, state);
+	doneConfigParser(state);
+}
+
+// returns the median MB/s over the runs
+static double measure(void (*parse)(const char*, size_t), const char *data, size_t size)
+{
+	const long iterations = 1 + (long)(megabytes * 1e6 / size);
+	double results[runs];
+
+	parse(data, size);
+	for (int run=0; run<runs; run++) {
+		struct timespec start, end;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (long i=0; i<iterations; i++)
+			parse(data, size);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		results[run] = iterations * size / 1e6 / elapsedSeconds(&start, &end);
+	}
+	qsort(results, runs, sizeof(double), compareDouble);
+	return results[runs / 2];
+}
+
+static void printHelp()
+{
+	puts("parser_throughput [-m megabytes] [-k entries] [-r runs]\n"
+	     "    -m -- input parsed per run and case, in MB (16)\n"
+	     "    -k -- man lines of the options and entries of the override (200)\n"
+	     "    -r -- runs, median is reported (5)");
+}
+
+int main(int argc, char *argv[])
+{
+	char *options, *override;
+	size_t options_size = 0, override_size = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:k:r:h")) != -1) {
+		switch (opt) {
+			case 'm':
+				megabytes = atof(optarg);
+				break;
+			case 'k':
+				entries = atoi(optarg);
+				break;
+			case 'r':
+				runs = atoi(optarg);
+				break;
+			default:
+				printHelp();
+				return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (megabytes <= 0 || entries < 1 || runs < 1) {
+		printHelp();
+		return 1;
+	}
+
+	options = generateOptions(&options_size);
+	override = generateOverride(&override_size);
+	if (options == NULL || override == NULL) {
+		perror("open_memstream");
+		return 1;
+	}
+
+	printf("options:  %8zu bytes\n", options_size);
+	printf("  buffer at once:   %8.1f MB/s\n", measure(parseOptionsAtOnce, options, options_size));
+	printf("  whole:            %8.1f MB/s\n", measure(parseOptionsWhole, options, options_size));
+	printf("  in 1 KiB reads:   %8.1f MB/s\n", measure(parseOptionsInReads, options, options_size));
+	printf("override: %8zu bytes\n", override_size);
+	printf("  parse, not found: %8.1f MB/s\n", measure(parseOverrideMiss, override, override_size));
+	printf("  parse and update: %8.1f MB/s\n", measure(updateOverride, override, override_size));
+
+	free(options);
+	free(override);
+	return 0;
+}
@@ -0,0 +1,52 @@
+#!/bin/sh
+# Training workload for the profile-guided build, run by `make pgo-train`
+# in a build configured with -DENABLE_PGO=ON -DPGO_PHASE=GENERATE.
+#
+#   pgo_train.sh alts library_dir config_dir...
+#
+# Every config_dir is listed, each binary in it is listed, queried,
+# overridden and executed through a symlink, which goes through
+# libalts_exec_default() and the options and config parsers.
+
+set -e
+
+if [ $# -lt 3 ]; then
+	echo "usage: $0 alts library_dir config_dir..." >&2
+	exit 1
+fi
+
+ALTS=$1
+export LD_LIBRARY_PATH=$2
+shift 2
+
+WORK_DIR=$(mktemp -d /tmp/libalternatives_pgo_XXXXXX)
+trap 'rm -rf "$WORK_DIR"' EXIT
+export XDG_CONFIG_HOME=$WORK_DIR
+
+ROUNDS=${PGO_TRAIN_ROUNDS:-20}
+
+for config_dir in "$@"; do
+	export LIBALTERNATIVES_TRAINING_CONFIG_DIR=$config_dir
+	binaries=$(cd "$config_dir" && for f in */; do echo "${f%/}"; done)
+
+	round=0
+	while [ $round -lt "$ROUNDS" ]; do
+		"$ALTS" -l >/dev/null 2>&1 || true
+		for binary in $binaries; do
+			ln -sf "$ALTS" "$WORK_DIR/$binary"
+			"$ALTS" -l "$binary" >/dev/null 2>&1 || true
+			"$ALTS" -t "$binary" >/dev/null 2>&1 || true
+			"$WORK_DIR/$binary" >/dev/null 2>&1 || true
+		done
+
+		# some rounds with user overrides, which are parsed on every exec
+		if [ $((round % 4)) -eq 0 ]; then
+			for binary in $binaries; do
+				"$ALTS" -u -n "$binary" -p 10 >/dev/null 2>&1 || true
+				"$WORK_DIR/$binary" >/dev/null 2>&1 || true
+				"$ALTS" -u -n "$binary" >/dev/null 2>&1 || true
+			done
+		fi
+		round=$((round + 1))
+	done
+done
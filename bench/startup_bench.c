@@ -0,0 +1,173 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Startup cost of the dynamic alts against the static exec only alts.
+ *
+ * Both are spawned through a symlink named after the binary, like
+ * packages install them. The binaries of the build directory resolve
+ * against the configured CONFIG_DIR. Without an installed alternative
+ * for the name, both fail after the lookup, which still measures loading
+ * and resolving, but not executing the target.
+ */
+
+#define _GNU_SOURCE
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+extern char **environ;
+
+static char tree_path[] = "/tmp/libalternatives_startup_XXXXXX";
+static const char *binary_name = "startup_bench_unknown";
+static int iterations = 1000, runs = 5;
+
+static double elapsedSeconds(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+	const double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static int spawnAndWait(const char *path, char *argv[], const posix_spawn_file_actions_t *actions)
+{
+	pid_t pid;
+	int status;
+
+	if (posix_spawn(&pid, path, actions, NULL, argv, environ) != 0)
+		return -1;
+
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR)
+			return -1;
+	}
+	return 0;
+}
+
+// returns median microseconds per exec of binary_name linked to program
+static double runStartup(const char *program)
+{
+	char link_path[512];
+	char *argv[] = { (char*)binary_name, NULL };
+	posix_spawn_file_actions_t actions;
+	double results[runs];
+
+	snprintf(link_path, sizeof(link_path), "%s/%s", tree_path, binary_name);
+	unlink(link_path);
+	if (symlink(program, link_path) < 0)
+		return -1;
+
+	// failed lookups report on stderr
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+	posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+
+	// warm up page cache and dentries
+	spawnAndWait(link_path, argv, &actions);
+
+	for (int run=0; run<runs; run++) {
+		struct timespec start, end;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i=0; i<iterations; i++) {
+			if (spawnAndWait(link_path, argv, &actions) < 0) {
+				posix_spawn_file_actions_destroy(&actions);
+				return -1;
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		results[run] = elapsedSeconds(&start, &end) * 1e6 / iterations;
+	}
+
+	posix_spawn_file_actions_destroy(&actions);
+	unlink(link_path);
+	qsort(results, runs, sizeof(double), compareDouble);
+	return results[runs / 2];
+}
+
+static void printHelp()
+{
+	puts("startup_bench [-n name] [-i iterations] [-r runs]\n"
+	     "    -n -- binary name to execute (startup_bench_unknown)\n"
+	     "    -i -- execs per run (1000)\n"
+	     "    -r -- runs per binary, median is reported (5)");
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+	double baseline, dynamic, exec_only;
+
+	while ((opt = getopt(argc, argv, "n:i:r:h")) != -1) {
+		switch (opt) {
+			case 'n':
+				binary_name = optarg;
+				break;
+			case 'i':
+				iterations = atoi(optarg);
+				break;
+			case 'r':
+				runs = atoi(optarg);
+				break;
+			default:
+				printHelp();
+				return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (iterations < 1 || runs < 1 || strchr(binary_name, '/') != NULL) {
+		printHelp();
+		return 1;
+	}
+
+	if (mkdtemp(tree_path) == NULL) {
+		perror("Cannot create link directory");
+		return 1;
+	}
+
+	// the build tree alts is not installed next to its library
+	setenv("LD_LIBRARY_PATH", LIBRARY_DIR, 1);
+
+	baseline = runStartup("/bin/true");
+	dynamic = runStartup(ALTS_PATH);
+	exec_only = runStartup(ALTS_EXEC_PATH);
+
+	rmdir(tree_path);
+
+	if (baseline < 0 || dynamic < 0 || exec_only < 0) {
+		fputs("Spawning failed\n", stderr);
+		return 1;
+	}
+
+	printf("/bin/true:         %8.1f us per exec\n", baseline);
+	printf("dynamic alts:      %8.1f us per exec\n", dynamic);
+	printf("exec only alts:    %8.1f us per exec\n", exec_only);
+	printf("speedup:           %8.2fx\n", dynamic / exec_only);
+	return 0;
+}
@@ -0,0 +1,51 @@
+# Writes the library sources as a single translation unit.
+#
+#   cmake -DSOURCE_DIR=src -DSOURCES="a.c;b.c" -DOUTPUT=amalgam.c -P Amalgamate.cmake
+#
+# Local headers, also those included by local headers, are inlined
+# where they are first included and dropped afterwards. Feature test
+# macros are defined once at the top, since they must precede all system
+# headers.
+
+set(amalgam_included "")
+
+function(inline_local_includes content_var)
+    set(content "${${content_var}}")
+    string(REGEX MATCHALL "#include \"[^\"]+\"" includes "${content}")
+
+    foreach(include ${includes})
+        string(REGEX REPLACE "#include \"([^\"]+)\"" "\\1" header "${include}")
+        set(replacement "")
+
+        list(FIND amalgam_included "${header}" found)
+        if(found EQUAL -1)
+            list(APPEND amalgam_included "${header}")
+            set(amalgam_included "${amalgam_included}" PARENT_SCOPE)
+
+            file(READ "${SOURCE_DIR}/${header}" replacement)
+            string(REGEX REPLACE "#pragma once[^\n]*\n" "" replacement "${replacement}")
+            # headers including other local headers
+            inline_local_includes(replacement)
+            set(amalgam_included "${amalgam_included}" PARENT_SCOPE)
+            set(replacement "/* ${header} */\n${replacement}")
+        endif()
+
+        string(REPLACE "${include}" "${replacement}" content "${content}")
+    endforeach()
+
+    set(${content_var} "${content}" PARENT_SCOPE)
+endfunction()
+
+set(amalgam "/* Generated from the libalternatives sources by cmake/Amalgamate.cmake, do not edit. */\n")
+string(APPEND amalgam "#define __USE_MISC 1\n#define _GNU_SOURCE 1\n")
+
+foreach(source ${SOURCES})
+    file(READ "${SOURCE_DIR}/${source}" content)
+    string(REGEX REPLACE "#define (_GNU_SOURCE|__USE_MISC)[^\n]*\n" "\n" content "${content}")
+    inline_local_includes(content)
+    string(APPEND amalgam "/* ${source} */\n${content}")
+endforeach()
+
+file(WRITE "${OUTPUT}.tmp" "${amalgam}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
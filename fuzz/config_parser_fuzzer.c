@@ -0,0 +1,96 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Fuzz target of parseConfigData() and the override updates.
+ *
+ * The input is parsed as a user override for "editor". Whatever it
+ * holds, the parsed priority is never negative, and the config returned
+ * by setting or resetting the priority parses back to what was set.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/libalternatives.h"
+#include "../src/parser.h"
+
+#define BINARY_NAME "editor"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static int parseConfig(const char *buffer)
+{
+	struct ConfigParserState *state = initConfigParser(BINARY_NAME);
+	int priority;
+
+	if (state == NULL)
+		abort();
+	priority = parseConfigData(buffer, state);
+	doneConfigParser(state);
+	return priority;
+}
+
+static void checkUpdate(const char *buffer, int priority)
+{
+	struct ConfigParserState *state = initConfigParser(BINARY_NAME);
+	const char *updated;
+
+	if (state == NULL || parseConfigData(buffer, state) < 0)
+		abort();
+
+	if (priority > 0)
+		updated = setBinaryPriorityAndReturnUpdatedConfig(priority, state);
+	else
+		updated = resetToDefaultPriorityAndReturnUpdatedConfig(state);
+
+	if (updated == NULL || parseConfig(updated) != priority) {
+		fprintf(stderr, "config updated to priority %d does not parse back\n", priority);
+		abort();
+	}
+	doneConfigParser(state);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	// the library reads the whole override into a string
+	char *buffer = malloc(size + 1);
+	uint32_t seed = 1;
+	int priority;
+
+	if (buffer == NULL)
+		return 0;
+	memcpy(buffer, data, size);
+	buffer[size] = '\0';
+
+	if (parseConfig(buffer) < 0) {
+		fprintf(stderr, "negative priority parsed\n");
+		abort();
+	}
+
+	// a priority of the input, so that the large ones are written too
+	for (size_t i=0; i<size && i<sizeof(seed); i++)
+		seed = seed << 8 | data[i];
+	priority = 1 + seed % INT_MAX;
+
+	checkUpdate(buffer, priority);
+	checkUpdate(buffer, 0);
+
+	free(buffer);
+	return 0;
+}
@@ -0,0 +1,147 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Fuzz target of parseOptionsData() and parseOptionsBuffer().
+ *
+ * The parser is a state machine that can stop at any byte, so options
+ * can be read in chunks of whatever size read() returns. The input is
+ * parsed whole, one byte at a time, in 1 KiB chunks and in chunks of
+ * pseudo-random sizes, and the results must be the same as those of
+ * parseOptionsBuffer(), which the library uses on the whole file.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/libalternatives.h"
+#include "../src/parser.h"
+
+#define PRIORITY 10
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static struct AlternativeLink* parseInChunks(const char *data, size_t size, size_t (*next_chunk)(uint32_t*), uint32_t seed)
+{
+	struct OptionsParserState *state = initOptionsParser();
+
+	if (state == NULL)
+		abort();
+
+	for (size_t pos=0; pos<size; ) {
+		size_t len = next_chunk(&seed);
+
+		if (len == 0 || len > size - pos)
+			len = size - pos;
+		if (parseOptionsData(data + pos, len, state) < 0)
+			break;
+		pos += len;
+	}
+
+	return doneOptionsParser(PRIORITY, state);
+}
+
+static size_t wholeChunk(uint32_t *seed)
+{
+	(void)seed;
+	return 0;
+}
+
+static size_t byteChunk(uint32_t *seed)
+{
+	(void)seed;
+	return 1;
+}
+
+static size_t libraryChunk(uint32_t *seed)
+{
+	(void)seed;
+	return 1024;
+}
+
+// xorshift, so that a crash reproduces from the input alone
+static size_t randomChunk(uint32_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return 1 + *seed % 64;
+}
+
+static uint32_t hashInput(const uint8_t *data, size_t size)
+{
+	uint32_t hash = 2166136261u;
+
+	for (size_t i=0; i<size; i++)
+		hash = (hash ^ data[i]) * 16777619u;
+	return hash != 0 ? hash : 1;
+}
+
+static void compareLinks(const struct AlternativeLink *expected, const struct AlternativeLink *links, const char *how)
+{
+	if (expected == NULL || links == NULL) {
+		if (expected != links)
+			goto mismatch;
+		return;
+	}
+
+	for (;; expected++, links++) {
+		if (expected->type != links->type)
+			goto mismatch;
+		if (expected->type == ALTLINK_EOL)
+			return;
+		if (expected->priority != PRIORITY || links->priority != PRIORITY)
+			goto mismatch;
+		if (expected->options != links->options)
+			goto mismatch;
+		if (expected->target == NULL || links->target == NULL || strcmp(expected->target, links->target) != 0)
+			goto mismatch;
+	}
+
+mismatch:
+	fprintf(stderr, "options parsed %s differ from parseOptionsBuffer()\n", how);
+	abort();
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	const char *buffer = (const char*)data;
+	const uint32_t seed = hashInput(data, size);
+	struct AlternativeLink *whole, *links;
+
+	if (parseOptionsBuffer(buffer, size, PRIORITY, &whole) != 0)
+		whole = NULL;
+
+	links = parseInChunks(buffer, size, wholeChunk, seed);
+	compareLinks(whole, links, "whole");
+	free(links);
+
+	links = parseInChunks(buffer, size, byteChunk, seed);
+	compareLinks(whole, links, "byte by byte");
+	free(links);
+
+	links = parseInChunks(buffer, size, libraryChunk, seed);
+	compareLinks(whole, links, "in 1 KiB chunks");
+	free(links);
+
+	links = parseInChunks(buffer, size, randomChunk, seed);
+	compareLinks(whole, links, "in random chunks");
+	free(links);
+
+	free(whole);
+	return 0;
+}
@@ -0,0 +1,123 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Runs a fuzz target once on every file given, or found under the
+ * directories given, without libFuzzer. The corpus is replayed this way
+ * by ctest, and crashes found by the fuzzers reproduce with any compiler.
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static int replayFile(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	uint8_t *data = NULL;
+	size_t size = 0, allocated = 0, n;
+	int ret = -1;
+
+	if (file == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	do {
+		if (size == allocated) {
+			uint8_t *tmp = realloc(data, allocated + 4096);
+			if (tmp == NULL)
+				goto err;
+			data = tmp;
+			allocated += 4096;
+		}
+		n = fread(data + size, 1, allocated - size, file);
+		size += n;
+	} while (n > 0);
+	if (ferror(file)) {
+		perror(path);
+		goto err;
+	}
+
+	LLVMFuzzerTestOneInput(data, size);
+	ret = 0;
+
+err:
+	free(data);
+	fclose(file);
+	return ret;
+}
+
+// returns number of files replayed, or -1 on error
+static int replayPath(const char *path)
+{
+	struct stat st;
+	struct dirent **entries;
+	int count = 0, n;
+
+	if (stat(path, &st) != 0) {
+		perror(path);
+		return -1;
+	}
+	if (!S_ISDIR(st.st_mode))
+		return replayFile(path) == 0 ? 1 : -1;
+
+	n = scandir(path, &entries, NULL, alphasort);
+	if (n < 0) {
+		perror(path);
+		return -1;
+	}
+	for (int i=0; i<n; i++) {
+		char *entry_path;
+		int ret = 0;
+
+		if (entries[i]->d_name[0] != '.' && asprintf(&entry_path, "%s/%s", path, entries[i]->d_name) >= 0) {
+			ret = replayPath(entry_path);
+			free(entry_path);
+		}
+		if (ret < 0 || count < 0)
+			count = -1;
+		else
+			count += ret;
+		free(entries[i]);
+	}
+	free(entries);
+	return count;
+}
+
+int main(int argc, char *argv[])
+{
+	int total = 0;
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <file or directory>...\n", argv[0]);
+		return 1;
+	}
+
+	for (int i=1; i<argc; i++) {
+		const int count = replayPath(argv[i]);
+		if (count < 0)
+			return 1;
+		total += count;
+	}
+
+	printf("%d inputs replayed\n", total);
+	return total > 0 ? 0 : 1;
+}
@@ -1,4 +1,4 @@
-SOURCES = libalternatives.c options_parser.c config_parser.c
+SOURCES = libalternatives.c options_parser.c config_parser.c dirscan.c inherit.c resolver.c launcher.c trace.c stats.c usage.c
 HEADERS = libalternatives.h
 
 include Makefile.gnu.common
@@ -0,0 +1,107 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE 1
+
+#include <fcntl.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libalternatives.h"
+#include "internal.h"
+
+#define CAPTURE_ENV "LIBALTERNATIVES_CAPTURE"
+
+// environment switch, see isEnvSwitchEnabled()
+int libalternatives_capture = 0;
+
+// set by the tests, otherwise read from the environment
+static const char *capture_path;
+static __thread int capture_depth;
+
+// functions without the libalts_ prefix, as alts-replay knows them
+static const char *const function_names[LIBALTS_STATS_FUNCTION_COUNT] = {
+	"load_highest_priority_binary_alternatives",
+	"load_exact_priority_binary_alternatives",
+	"load_available_binaries",
+	"load_binary_priorities",
+	"read_binary_configured_priority_from_file",
+	"write_binary_configured_priority_to_file",
+	"read_configured_priority",
+	"exec_default",
+	"resolve_default_binary",
+	"get_default_manpages",
+	"get_generation",
+	"export_inherited_cache",
+	"generate_launcher",
+};
+
+#ifdef UNITTESTS
+void setCapturePath(const char *path)
+{
+	capture_path = path;
+	libalternatives_capture = path != NULL ? 2 : 1;
+}
+#endif
+
+int beginCapture()
+{
+	if (!isEnvSwitchEnabled(&libalternatives_capture, CAPTURE_ENV, 1))
+		return 0;
+	return capture_depth++ == 0 ? 1 : 2;
+}
+
+void endCapture(int capture_call, int function, const char *binary_name, int argument, int result)
+{
+	const int saved_error = errno;
+	char line[512];
+	int len, fd;
+
+	capture_depth--;
+	if (capture_call != 1 || function < 0 || function >= LIBALTS_STATS_FUNCTION_COUNT)
+		return;
+
+	// names that would break the record are not captured
+	if (binary_name == NULL)
+		binary_name = "";
+	if (strpbrk(binary_name, "\t\n") != NULL)
+		return;
+
+	len = snprintf(line, sizeof(line), "%s\t%s\t%d\t%d\n",
+	               function_names[function], binary_name, argument, result);
+	if (len < 0 || len >= (int)sizeof(line))
+		return;
+
+	const char *path = capture_path != NULL ? capture_path : secure_getenv(CAPTURE_ENV);
+	if (path == NULL)
+		return;
+
+	fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0)
+		goto end;
+
+	// a single write, so lines of concurrent processes are not mixed
+	const ssize_t written = write(fd, line, len);
+	(void)written;
+	close(fd);
+
+end:
+	errno = saved_error;
+}
@@ -24,6 +24,7 @@
 #include <stdbool.h>
 
 #include "parser.h"
+#include "stats.h"
 
 /*----------------------------------------------------------------------*/
 
@@ -48,8 +49,8 @@ static char *ltrim(char *s)
 static char *rtrim(char *s)
 {
     char* back = s + strlen(s);
-    while(isspace(*--back));
-    *(back+1) = '\0';
+    while(back > s && isspace(back[-1])) back--;
+    *back = '\0';
     return s;
 }
 
@@ -62,8 +63,8 @@ static bool is_key(const char *buffer, const char *key, int buffer_len)
 {
   int ret = true;
   char *raw_key, *parsed_key = NULL;
-  raw_key = strndup(buffer,buffer_len);
-  parsed_key = strdup(trim(raw_key)); /* strip whitespaces */
+  raw_key = statsStrndup(buffer,buffer_len);
+  parsed_key = statsStrdup(trim(raw_key)); /* strip whitespaces */
   free(raw_key);
   if (strcmp(parsed_key,key) != 0)
     ret = false;
@@ -86,8 +87,10 @@ static void free_buffer(char **buffer)
  */
 static const char *setBinaryPriority(int priority, struct ConfigParserState *state)
 {
-  char *buf = state->complete_content;
-  state->complete_content = strdup("");
+  /* strsep advances buf, so the old content is freed through begin_buf */
+  char *begin_buf __attribute__ ((__cleanup__(free_buffer))) = state->complete_content;
+  char *buf = begin_buf;
+  state->complete_content = statsStrdup("");
   bool entry_found = false;
   char *line;
   while ((line = strsep(&buf, "\n")) != NULL) {
@@ -104,7 +107,7 @@ static const char *setBinaryPriority(int priority, struct ConfigParserState *sta
 	  {
 	    /* update; entry will be removed if priority <= 0 */
 	    char *content = state->complete_content;
-	    asprintf(&state->complete_content, "%s%s%s=%d", content,
+	    statsAsprintf(&state->complete_content, "%s%s%s=%d", content,
 		     strlen(content) == 0 ? "" : "\n",
 		     state->binary_name, priority);
 	    free(content);
@@ -114,18 +117,17 @@ static const char *setBinaryPriority(int priority, struct ConfigParserState *sta
       }
     }
     char *content = state->complete_content;
-    asprintf(&state->complete_content, "%s%s%s", content,
+    statsAsprintf(&state->complete_content, "%s%s%s", content,
 	     strlen(content) == 0 ? "" : "\n",
 	     line);
     free(content);
   }
-  free(buf);
 
   if (!entry_found && priority > 0)
   {
     /* appending */
     char *content = state->complete_content;
-    asprintf(&state->complete_content, "%s%s%s=%d", content,
+    statsAsprintf(&state->complete_content, "%s%s%s=%d", content,
 	     strlen(content) == 0 ? "" : "\n",
 	     state->binary_name, priority);
     free(content);
@@ -141,11 +143,11 @@ struct ConfigParserState* initConfigParser(const char *binary_name)
   if (binary_name == NULL)
     return NULL;
 
-  struct ConfigParserState *state = (struct ConfigParserState*)malloc(sizeof(struct ConfigParserState));
+  struct ConfigParserState *state = (struct ConfigParserState*)statsMalloc(sizeof(struct ConfigParserState));
 
-  state->binary_name = strdup(binary_name);
+  state->binary_name = statsStrdup(binary_name);
   state->priority = 0;
-  state->complete_content = strdup("");
+  state->complete_content = statsStrdup("");
 
   return state;
 }
@@ -153,11 +155,11 @@ struct ConfigParserState* initConfigParser(const char *binary_name)
 int parseConfigData(const char *buffer, struct ConfigParserState *state)
 {
   /* strsep changes the buffer. So we need a copy of it.*/
-  char *begin_buf __attribute__ ((__cleanup__(free_buffer))) = strdup(buffer);
+  char *begin_buf __attribute__ ((__cleanup__(free_buffer))) = statsStrdup(buffer);
   char *buf = begin_buf;
 
   free(state->complete_content);
-  state->complete_content = strdup(buffer);
+  state->complete_content = statsStrdup(buffer);
 
   char *line;
   while (state->priority == 0 && (line = strsep(&buf, "\n")) != NULL) {
@@ -178,17 +180,18 @@ int parseConfigData(const char *buffer, struct ConfigParserState *state)
     const char *comment_pos = strstr(line,"#"); /* stripping comment */
     char *raw_value = NULL;
     if (comment_pos == NULL) {
-      raw_value = strdup(equal_pos+1);
+      raw_value = statsStrdup(equal_pos+1);
     } else {
-      raw_value = strndup(equal_pos+1,comment_pos-equal_pos-1);
+      raw_value = statsStrndup(equal_pos+1,comment_pos-equal_pos-1);
     }
     char *endptr = NULL;
+    errno = 0;
     long int val = strtol(raw_value, &endptr, 10);
     if ((errno == ERANGE && (val == LONG_MAX || val == LONG_MIN))
         || (errno != 0 && val == 0)
         || (endptr == raw_value)   /* No digits were found. */
         || (*trim(endptr) != '\0') /* There is still a rest */
-        || val <= 0) {
+        || val <= 0 || val > INT_MAX) {
       free(raw_value);
       continue;
     }
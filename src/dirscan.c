@@ -0,0 +1,89 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE 1
+
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "internal.h"
+#include "stats.h"
+
+int openDirScanner(struct DirScanner *scanner, int dirfd, const char *path)
+{
+	scanner->pos = 0;
+	scanner->len = 0;
+	scanner->fd = openat(dirfd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (scanner->fd < 0)
+		return -1;
+
+	STATS_ADD(directories_scanned, 1);
+	return 0;
+}
+
+const char* readDirScanner(struct DirScanner *scanner, unsigned char *type)
+{
+	if (scanner->pos >= scanner->len) {
+		ssize_t len;
+
+		do {
+			len = getdents64(scanner->fd, scanner->buffer, sizeof(scanner->buffer));
+		} while (len < 0 && errno == EINTR);
+
+		if (len <= 0) {
+			if (len == 0)
+				errno = 0;
+			return NULL;
+		}
+
+		scanner->pos = 0;
+		scanner->len = len;
+	}
+
+	const struct dirent64 *entry = (const struct dirent64*)(scanner->buffer + scanner->pos);
+	scanner->pos += entry->d_reclen;
+
+	*type = entry->d_type;
+	return entry->d_name;
+}
+
+int resolveDirScannerType(struct DirScanner *scanner, const char *name, int flags, unsigned char *type)
+{
+	struct statx info;
+
+	// only the file type is needed, so the filesystem does not have to
+	// synchronize the other attributes, eg. on NFS
+	if (statx(scanner->fd, name, flags | AT_STATX_DONT_SYNC, STATX_TYPE, &info) < 0)
+		return -1;
+
+	*type = IFTODT(info.stx_mode);
+	return 0;
+}
+
+void closeDirScanner(struct DirScanner *scanner)
+{
+	if (scanner->fd != -1) {
+		const int saved_error = errno;
+		close(scanner->fd);
+		errno = saved_error;
+	}
+	scanner->fd = -1;
+}
@@ -0,0 +1,223 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE 1
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "internal.h"
+#include "stats.h"
+
+/* Entries are separated by newlines, newest first:
+ *
+ *   <binary>:<options>:<dir sec>.<nsec>:<system sec>.<nsec>:<user sec>.<nsec>:<ino>:<size>:<ctime sec>.<nsec>:<options file>:<target>
+ *
+ * The timestamps are modification times of the binary's config directory
+ * and of both override files, 0.0 if missing, followed by the inode, size
+ * and change time of the options file the target was read from.
+ */
+
+#define INHERIT_CACHE_MAX_SIZE 4096
+
+struct InheritStamp
+{
+	struct timespec binary_dir, system_config, user_config;
+};
+
+int getModificationTime(const char *path, struct timespec *ts)
+{
+	struct stat st;
+
+	ts->tv_sec = 0;
+	ts->tv_nsec = 0;
+
+	if (path == NULL)
+		return 0;
+
+	if (stat(path, &st) < 0)
+		return errno == ENOENT ? 0 : -1;
+
+	*ts = st.st_mtim;
+	return 0;
+}
+
+int isRecentModificationTime(const struct timespec *ts, const struct timespec *now)
+{
+	return ts->tv_sec >= now->tv_sec - 1;
+}
+
+static int getStableModificationTime(const char *path, struct timespec *ts, const struct timespec *now)
+{
+	if (getModificationTime(path, ts) < 0)
+		return -1;
+
+	// timestamps are coarse, so a file changed in the last second may
+	// still change without its timestamp changing
+	return now != NULL && isRecentModificationTime(ts, now) ? -1 : 0;
+}
+
+static int getInheritStamp(const struct InheritPaths *paths, const char *binary_name, struct InheritStamp *stamp, const struct timespec *now)
+{
+	char path[PATH_MAX];
+
+	if ((size_t)snprintf(path, sizeof(path), "%s/%s", paths->config_dir, binary_name) >= sizeof(path))
+		return -1;
+
+	if (getStableModificationTime(path, &stamp->binary_dir, now) < 0 ||
+	    getStableModificationTime(paths->system_config, &stamp->system_config, now) < 0 ||
+	    getStableModificationTime(paths->user_config, &stamp->user_config, now) < 0)
+		return -1;
+
+	return 0;
+}
+
+static int isSameCachedTime(const struct timespec *a, long long sec, long nsec)
+{
+	return a->tv_sec == sec && a->tv_nsec == nsec;
+}
+
+// an options file edited in place keeps the time of its directory
+static int isSameOptionsFile(const char *path, unsigned long long ino, long long size, long long ctime_sec, long ctime_nsec)
+{
+	struct stat st;
+
+	if (lstat(path, &st) < 0 || !S_ISREG(st.st_mode))
+		return 0;
+
+	return (unsigned long long)st.st_ino == ino && (long long)st.st_size == size &&
+	       isSameCachedTime(&st.st_ctim, ctime_sec, ctime_nsec);
+}
+
+// returns start of the entry for binary_name, or NULL
+static const char* findEntry(const char *cache, const char *binary_name)
+{
+	const size_t len = strlen(binary_name);
+
+	while (cache != NULL && *cache != '\0') {
+		if (strncmp(cache, binary_name, len) == 0 && cache[len] == ':')
+			return cache;
+
+		cache = strchr(cache, '\n');
+		if (cache != NULL)
+			cache++;
+	}
+
+	return NULL;
+}
+
+int isInheritedCacheEnabled()
+{
+	return secure_getenv(INHERIT_CACHE_ENV) != NULL;
+}
+
+int lookupInheritedCache(const struct InheritPaths *paths, const char *binary_name, char **target, int *options)
+{
+	const char *entry = findEntry(secure_getenv(INHERIT_CACHE_ENV), binary_name);
+	struct InheritStamp stamp;
+	char options_file[PATH_MAX];
+	long long dir_sec, system_sec, user_sec, file_size, file_sec;
+	long dir_nsec, system_nsec, user_nsec, file_nsec;
+	unsigned long long file_ino;
+	int file_pos = 0;
+
+	if (entry == NULL)
+		return -1;
+
+	entry += strlen(binary_name) + 1;
+	if (sscanf(entry, "%d:%lld.%ld:%lld.%ld:%lld.%ld:%llu:%lld:%lld.%ld:%n", options, &dir_sec, &dir_nsec, &system_sec, &system_nsec, &user_sec, &user_nsec,
+	           &file_ino, &file_size, &file_sec, &file_nsec, &file_pos) != 11 || file_pos == 0)
+		return -1;
+
+	entry += file_pos;
+	const size_t file_len = strcspn(entry, ":\n");
+	if (entry[file_len] != ':' || file_len >= sizeof(options_file))
+		return -1;
+	memcpy(options_file, entry, file_len);
+	options_file[file_len] = '\0';
+
+	if (getInheritStamp(paths, binary_name, &stamp, NULL) < 0 ||
+	    !isSameCachedTime(&stamp.binary_dir, dir_sec, dir_nsec) ||
+	    !isSameCachedTime(&stamp.system_config, system_sec, system_nsec) ||
+	    !isSameCachedTime(&stamp.user_config, user_sec, user_nsec) ||
+	    !isSameOptionsFile(options_file, file_ino, file_size, file_sec, file_nsec))
+		return -1;
+
+	entry += file_len + 1;
+	*target = statsStrndup(entry, strcspn(entry, "\n"));
+	return *target == NULL ? -1 : 0;
+}
+
+int exportInheritedCache(const struct InheritPaths *paths, const char *binary_name, const struct OptionsFileStamp *file, const char *target, int options)
+{
+	const char *cache = secure_getenv(INHERIT_CACHE_ENV);
+	const size_t name_len = strlen(binary_name);
+	struct InheritStamp stamp;
+	struct timespec now;
+	char new_cache[INHERIT_CACHE_MAX_SIZE];
+	int len;
+
+	if (cache == NULL)
+		cache = "";
+
+	if (strpbrk(binary_name, ":\n") != NULL || strpbrk(file->path, ":\n") != NULL || strchr(target, '\n') != NULL)
+		return -1;
+
+	// the options file was stamped when it was read, before now
+	if (clock_gettime(CLOCK_REALTIME, &now) < 0 || getInheritStamp(paths, binary_name, &stamp, &now) < 0 ||
+	    isRecentModificationTime(&file->ctime, &now))
+		return -1;
+
+	len = snprintf(new_cache, sizeof(new_cache), "%s:%d:%lld.%ld:%lld.%ld:%lld.%ld:%llu:%lld:%lld.%ld:%s:%s",
+	               binary_name, options,
+	               (long long)stamp.binary_dir.tv_sec, stamp.binary_dir.tv_nsec,
+	               (long long)stamp.system_config.tv_sec, stamp.system_config.tv_nsec,
+	               (long long)stamp.user_config.tv_sec, stamp.user_config.tv_nsec,
+	               (unsigned long long)file->ino, (long long)file->size,
+	               (long long)file->ctime.tv_sec, file->ctime.tv_nsec,
+	               file->path, target);
+	if (len < 0 || (size_t)len >= sizeof(new_cache))
+		return -1;
+
+	// append older entries, except the replaced one, while they fit
+	while (*cache != '\0') {
+		const size_t entry_len = strcspn(cache, "\n");
+		const int is_replaced = strncmp(cache, binary_name, name_len) == 0 && cache[name_len] == ':';
+
+		if (!is_replaced) {
+			if ((size_t)len + 1 + entry_len >= sizeof(new_cache))
+				break;
+
+			new_cache[len++] = '\n';
+			memcpy(new_cache + len, cache, entry_len);
+			len += entry_len;
+		}
+
+		cache += entry_len;
+		if (*cache == '\n')
+			cache++;
+	}
+	new_cache[len] = '\0';
+
+	return setenv(INHERIT_CACHE_ENV, new_cache, 1);
+}
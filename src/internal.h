@@ -0,0 +1,325 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <sys/types.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct AlternativeLink;
+struct LibaltsUsage;
+
+// options file that a binary was resolved from. Editing it in place does
+// not change the modification time of its directory, so resolutions kept
+// beyond a process compare these too.
+struct OptionsFileStamp
+{
+	char path[PATH_MAX];
+	ino_t ino;
+	off_t size;
+	struct timespec ctime;
+};
+
+
+
+/* environment switches
+ * Opt-in features are enabled by a variable in the environment, which is
+ * read on first use. The state of a switch is 0 until the environment is
+ * checked, 1 if the feature is disabled and 2 if it is enabled, so that
+ * callers can skip the call while it is 1.
+ */
+
+// returns 1 if the variable name enables the feature, which takes "1",
+// or any non-empty value if any_value is set
+static inline int isEnvSwitchEnabled(int *state, const char *name, int any_value)
+{
+	int enabled = __atomic_load_n(state, __ATOMIC_ACQUIRE);
+
+	if (enabled == 0) {
+		const char *env = secure_getenv(name);
+
+		enabled = env != NULL && (any_value ? env[0] != '\0' : strcmp(env, "1") == 0) ? 2 : 1;
+		__atomic_store_n(state, enabled, __ATOMIC_RELEASE);
+	}
+	return enabled == 2;
+}
+
+
+
+/* dirscan.c
+ * Directory scanning that reads entries with getdents64() in large
+ * batches into a buffer that is part of the scanner, so no DIR stream
+ * is allocated. File types are resolved with statx() only on
+ * filesystems that do not report them in the directory entries.
+ */
+
+struct DirScanner
+{
+	int fd;
+	size_t pos, len;
+	char buffer[8192] __attribute__ ((aligned (8)));
+};
+
+// opens path relative to dirfd, or AT_FDCWD, for scanning
+// return 0 on success, -1 on error
+int openDirScanner(struct DirScanner *scanner, int dirfd, const char *path);
+
+// returns name of next entry and its DT_* type, which may be DT_UNKNOWN.
+// NULL at end of directory, with errno 0, or on error.
+const char* readDirScanner(struct DirScanner *scanner, unsigned char *type);
+
+// resolves DT_UNKNOWN type of an entry. flags are AT_* flags of statx()
+// return 0 on success, -1 on error
+int resolveDirScannerType(struct DirScanner *scanner, const char *name, int flags, unsigned char *type);
+
+void closeDirScanner(struct DirScanner *scanner);
+
+
+
+/* inherit.c
+ * Opt-in cache of resolved targets that is passed to descendant processes
+ * in the LIBALTERNATIVES_CACHE environment variable. It is enabled for a
+ * process tree by setting the variable, even to an empty value. Entries
+ * are validated against modification times of the binary's config
+ * directory and of both override files, and against the inode, size and
+ * change time of the options file the target was read from.
+ */
+
+#define INHERIT_CACHE_ENV "LIBALTERNATIVES_CACHE"
+
+struct InheritPaths
+{
+	const char *config_dir;
+	const char *system_config;
+	const char *user_config; // may be NULL
+};
+
+int isInheritedCacheEnabled();
+
+// return 0 and allocated target on a valid entry, -1 otherwise
+int lookupInheritedCache(const struct InheritPaths *paths, const char *binary_name, char **target, int *options);
+
+// adds or replaces the entry for binary_name, resolved from file, in the
+// environment
+// return 0 on success, -1 if the entry cannot be cached
+int exportInheritedCache(const struct InheritPaths *paths, const char *binary_name, const struct OptionsFileStamp *file, const char *target, int options);
+
+// modification time of path, or 0.0 if path is NULL or missing
+// return 0 on success, -1 on error
+int getModificationTime(const char *path, struct timespec *ts);
+
+// timestamps are coarse, so a file modified in the last second may change
+// again without a different timestamp
+int isRecentModificationTime(const struct timespec *ts, const struct timespec *now);
+
+
+
+/* launcher.c
+ * Launchers are copies of a small template program, alts-launcher, with
+ * the resolved target patched into its LauncherData. A launcher executes
+ * its target directly as long as the binary's config directory and both
+ * override files have the modification times recorded in it, and the
+ * selected options file its inode, size and change time. Otherwise it
+ * executes alts, which resolves the binary as usual.
+ */
+
+#ifndef LAUNCHER_TEMPLATE_PATH
+#define LAUNCHER_TEMPLATE_PATH "/usr/libexec/libalternatives/alts-launcher"
+#endif
+
+#ifndef ALTS_BINARY_PATH
+#define ALTS_BINARY_PATH "/usr/bin/alts"
+#endif
+
+#define LAUNCHER_MAGIC "ALTS-LAUNCHER-2"
+
+struct LauncherStamp
+{
+	long long sec; // 0.0 if missing
+	long nsec;
+};
+
+struct LauncherData
+{
+	char magic[16];
+	int options;
+	char binary_name[256];
+	char target[PATH_MAX];
+	char fallback[PATH_MAX]; // alts binary
+
+	char binary_dir[PATH_MAX];
+	char system_config[PATH_MAX];
+	char user_config[PATH_MAX]; // empty if unknown
+	struct LauncherStamp binary_dir_stamp, system_config_stamp, user_config_stamp;
+
+	char options_file[PATH_MAX]; // the target was read from
+	unsigned long long options_file_ino;
+	long long options_file_size;
+	struct LauncherStamp options_file_ctime;
+};
+
+// copies the template to output_path with its LauncherData replaced
+// return 0 on success, -1 on error
+int writeLauncher(const char *template_path, const char *output_path, const struct LauncherData *data);
+
+
+
+/* resolver.c
+ * Client of altsd, the optional resolver daemon. It keeps the parsed
+ * alternatives of all binaries and the system overrides in memory and
+ * answers over a SOCK_SEQPACKET Unix socket, one request and one reply
+ * per connection. The user override is read by the client and sent
+ * along, so the result matches loadAlternatives() in the library.
+ *
+ * Messages are in host byte order. A reply is the header followed by
+ * n_links ResolverLink records, each followed by its target string
+ * including the terminating NUL.
+ */
+
+#ifndef ALTSD_SOCKET_PATH
+#define ALTSD_SOCKET_PATH "/run/altsd.socket"
+#endif
+
+#define RESOLVER_TIMEOUT_MS 20
+#define RESOLVER_MAX_MESSAGE 16384
+
+struct ResolverRequest
+{
+	int user_priority; // <= 0 if no user override
+	char binary_name[256];
+};
+
+struct ResolverReplyHeader
+{
+	int status; // 0 or errno value
+	unsigned n_links;
+};
+
+struct ResolverLink
+{
+	int priority;
+	int type;
+	int options;
+	unsigned target_size;
+};
+
+// returns 0 and allocated alternatives if the daemon answered,
+// -1 if it is not running, too slow or has no answer
+int queryResolver(const char *binary_name, int user_priority, struct AlternativeLink **alternatives);
+
+
+
+/* trace.c
+ * LIBALTERNATIVES_TRACE=n times the phases of one in n executions and
+ * writes them as one line to stderr, or appended to
+ * LIBALTERNATIVES_TRACE_FILE. Disabled, each probe is a single branch.
+ */
+
+enum TracePhase
+{
+	TRACE_USER_CONFIG,
+	TRACE_SYSTEM_CONFIG,
+	TRACE_DIRECTORY_SCAN,
+	TRACE_OPTIONS_PARSE,
+	TRACE_PRE_EXEC, // from the resolved target up to, not including, the exec
+	TRACE_PHASE_COUNT
+};
+
+extern int libalternatives_trace;
+
+#define TRACE_BEGIN(phase) do { if (__builtin_expect(libalternatives_trace, 0)) beginTracePhase(phase); } while (0)
+#define TRACE_END(phase) do { if (__builtin_expect(libalternatives_trace, 0)) endTracePhase(phase); } while (0)
+
+// starts tracing the execution of binary_name if it is sampled
+void startTrace(const char *binary_name);
+void beginTracePhase(enum TracePhase phase);
+void endTracePhase(enum TracePhase phase);
+
+// writes the trace line and stops tracing, target may be NULL
+void emitTrace(const char *target, const char *source);
+
+
+
+/* usage.c
+ * Optional counters of executions per binary and priority, shared by all
+ * processes through a file. Counting is enabled by creating the file and
+ * setting LIBALTERNATIVES_USAGE=1, so other executions do not touch the
+ * file. An execution reads and writes its slot with pread() and pwrite()
+ * under an open file description lock of the slot alone, so a truncated
+ * file cannot fault. It does not wait for the lock, any failure or
+ * contention only skips the count. Slots are keyed by the hash of binary
+ * name and priority, and probed linearly.
+ */
+
+#ifndef USAGE_PATH
+#define USAGE_PATH "/var/lib/libalternatives/usage"
+#endif
+
+#define USAGE_ENV "LIBALTERNATIVES_USAGE"
+#define USAGE_MAGIC "ALTSUSE1"
+#define USAGE_SLOTS 1024
+#define USAGE_MAX_PROBES 16
+
+struct UsageHeader
+{
+	char magic[8];
+	uint32_t n_slots;
+	uint32_t slot_size;
+};
+
+struct UsageSlot
+{
+	uint64_t key; // 0 if free
+	uint64_t count;
+	int32_t priority;
+	char binary_name[108]; // truncated, key has the full name
+};
+
+// adds one execution if enabled, never waits and ignores all errors
+void countUsage(const char *path, const char *binary_name, int priority);
+
+// returns the counted slots as one allocation, names follow the entries
+// return 0 on success, -1 on error
+int loadUsage(const char *path, struct LibaltsUsage **usage, size_t *size);
+
+// atomically replaces the usage file with an empty one
+// return 0 on success, -1 on error
+int resetUsage(const char *path);
+
+
+
+/* capture.c
+ * LIBALTERNATIVES_CAPTURE=path appends one line for every call of a
+ * public function to path: the function, binary name, argument and
+ * result, separated by tabs. Calls made by other public functions are
+ * not recorded. bench/alts-replay issues the captured calls again.
+ * Disabled, each call checks a flag.
+ */
+
+extern int libalternatives_capture;
+
+// 0 if the call is not captured, 1 if it is and 2 if it is nested
+#define CAPTURE_BEGIN() const int capture_call = libalternatives_capture == 1 ? 0 : beginCapture()
+#define CAPTURE_END(function, binary_name, argument, result) \
+	do { if (__builtin_expect(capture_call, 0)) endCapture(capture_call, function, binary_name, argument, result); } while (0)
+
+int beginCapture();
+
+// function is an enum LibaltsStatsFunction, binary_name may be NULL
+void endCapture(int capture_call, int function, const char *binary_name, int argument, int result);
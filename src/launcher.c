@@ -0,0 +1,154 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE 1
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "internal.h"
+#include "stats.h"
+
+// the template should be small, this only guards against wrong files
+#define MAX_TEMPLATE_SIZE (16 << 20)
+
+static char* readTemplate(const char *template_path, size_t *size)
+{
+	struct stat st;
+	char *data = NULL;
+	size_t pos = 0;
+
+	const int fd = open(template_path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) < 0)
+		goto err;
+	if (!S_ISREG(st.st_mode) || st.st_size > MAX_TEMPLATE_SIZE) {
+		errno = ENOEXEC;
+		goto err;
+	}
+
+	data = statsMalloc(st.st_size);
+	if (data == NULL)
+		goto err;
+
+	while (pos < (size_t)st.st_size) {
+		const ssize_t len = read(fd, data + pos, st.st_size - pos);
+		if (len < 0 && errno == EINTR)
+			continue;
+		if (len <= 0) {
+			errno = (len == 0 ? EIO : errno);
+			goto err;
+		}
+		pos += len;
+	}
+
+	close(fd);
+	*size = pos;
+	return data;
+
+err:
+	free(data);
+	const int saved_error = errno;
+	close(fd);
+	errno = saved_error;
+	return NULL;
+}
+
+// returns the only copy of LauncherData in the template, or NULL
+static char* findLauncherData(char *data, size_t size)
+{
+	char *found = memmem(data, size, LAUNCHER_MAGIC, sizeof(LAUNCHER_MAGIC));
+	if (found == NULL || (size_t)(found - data) + sizeof(struct LauncherData) > size)
+		return NULL;
+
+	const size_t next = found - data + sizeof(LAUNCHER_MAGIC);
+	if (memmem(data + next, size - next, LAUNCHER_MAGIC, sizeof(LAUNCHER_MAGIC)) != NULL)
+		return NULL;
+
+	return found;
+}
+
+int writeLauncher(const char *template_path, const char *output_path, const struct LauncherData *data)
+{
+	size_t size;
+	char *launcher = readTemplate(template_path, &size);
+	char *temp_path = NULL;
+	int fd = -1, ret = -1, is_temp_created = 0;
+
+	if (launcher == NULL)
+		return -1;
+
+	char *launcher_data = findLauncherData(launcher, size);
+	if (launcher_data == NULL) {
+		errno = ENOEXEC;
+		goto err;
+	}
+	memcpy(launcher_data, data, sizeof(*data));
+
+	if (statsAsprintf(&temp_path, "%s.XXXXXX", output_path) < 0) {
+		temp_path = NULL;
+		goto err;
+	}
+
+	fd = mkostemp(temp_path, O_CLOEXEC);
+	if (fd < 0)
+		goto err;
+	is_temp_created = 1;
+
+	for (size_t pos = 0; pos < size; ) {
+		const ssize_t len = write(fd, launcher + pos, size - pos);
+		if (len < 0 && errno == EINTR)
+			continue;
+		if (len < 0)
+			goto err;
+		pos += len;
+	}
+
+	if (fchmod(fd, 0755) < 0)
+		goto err;
+
+	ret = close(fd);
+	fd = -1;
+	if (ret < 0)
+		goto err;
+	ret = -1;
+
+	if (rename(temp_path, output_path) < 0)
+		goto err;
+	ret = 0;
+
+err:
+	if (ret != 0) {
+		const int saved_error = errno;
+		if (fd >= 0)
+			close(fd);
+		if (is_temp_created)
+			unlink(temp_path);
+		errno = saved_error;
+	}
+	free(temp_path);
+	free(launcher);
+	return ret;
+}
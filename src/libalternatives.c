@@ -21,9 +21,14 @@
 #include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/file.h>
 #include <fcntl.h>
+#ifdef USE_EXECVEAT
+#include <sys/syscall.h>
+#endif
 
 #include <errno.h>
+#include <limits.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -31,6 +36,9 @@
 
 #include "libalternatives.h"
 #include "parser.h"
+#include "internal.h"
+#include "probes.h"
+#include "stats.h"
 
 #if !defined(ETC_PATH)
 #error "ETC_PATH is undefined"
@@ -58,7 +66,12 @@ const char user_override_path[] = "";
 #endif
 
 int libalternatives_debug = 0;
+#ifdef LIBALTS_EXEC_ONLY
+// the exec only alts drops all debug output
+#define IS_DEBUG 0
+#else
 #define IS_DEBUG unlikely(libalternatives_debug)
+#endif
 
 static char *__config_path = CONFIG_DIR;
 static const char* getConfigDirectory()
@@ -66,24 +79,37 @@ static const char* getConfigDirectory()
 	return __config_path;
 }
 
+#ifdef PGO_TRAINING
+// the instrumented build is trained on the test trees, see bench/pgo_train.sh
+__attribute__((constructor))
+static void setTrainingConfigDirectory()
+{
+	const char *config_directory = getenv("LIBALTERNATIVES_TRAINING_CONFIG_DIR");
+	if (config_directory != NULL)
+		__config_path = statsStrdup(config_directory);
+}
+#endif
+
 #ifdef UNITTESTS
 void setConfigDirectory(const char *config_directory)
 {
 	if (strcmp(__config_path, CONFIG_DIR) != 0)
 		free(__config_path);
-	__config_path = strdup(config_directory);
+	__config_path = statsStrdup(config_directory);
 }
 #endif
 
 static void checkEnvDebug()
 {
+#ifndef LIBALTS_EXEC_ONLY
 	const char *debug = secure_getenv("LIBALTERNATIVES_DEBUG");
 	libalternatives_debug = ( debug != NULL && debug[0] == '1' && debug[1] == '\x00' );
+#endif
 }
 
 static const char *concat_str_safe(const char *str1, int len1, const char *str2, int len2)
 {
-	char *str = malloc(len1 + len2);
+	char *str = statsMalloc(len1 + len2);
 	strncpy(str, str1, len1);
 	strncpy(str+len1, str2, len2);
 	return str;
@@ -112,169 +138,197 @@ static int PriorityMatch_getExact(int a, __attribute__((unused)) int b, void *pr
 	return (a == *(int*)prio ? 1 : 0);
 }
 
-static int findAltConfig(const char *binary_name, PriorityMatchFunction priority_match_func, int *prio, void *data)
+// returns fd of the selected options file, and its path in file if not NULL
+static int findAltConfig(const char *binary_name, PriorityMatchFunction priority_match_func, int *prio, void *data, struct OptionsFileStamp *file)
 {
 	int retfd = -1;
-	int configdirfd = -1;
-	int binaryconfigdirfd = -1;
 	int saved_error = 0;
-	DIR *dir = NULL;
+	struct DirScanner scanner;
 	const char *filename = NULL;
+	const char *name;
+	unsigned char type;
+	char path[PATH_MAX];
 
 	*prio = 0;
+	scanner.fd = -1;
+	PROBE1(find_config__entry, binary_name);
 
-	configdirfd = open(getConfigDirectory(), O_DIRECTORY, O_RDONLY | O_CLOEXEC);
-	if (configdirfd < 0)
-		goto err;
-
-	binaryconfigdirfd = openat(configdirfd, binary_name, O_DIRECTORY, O_RDONLY | O_CLOEXEC);
-	if (binaryconfigdirfd < 0)
+	if ((size_t)snprintf(path, sizeof(path), "%s/%s", getConfigDirectory(), binary_name) >= sizeof(path)) {
+		errno = ENAMETOOLONG;
 		goto err;
+	}
 
-	close(configdirfd);
-	configdirfd = -1;
-
-	dir = fdopendir(dup(binaryconfigdirfd));
-	if (dir == NULL)
+	if (openDirScanner(&scanner, AT_FDCWD, path) < 0)
 		goto err;
 
-	struct dirent *dirptr;
-
-	errno = 0;
-	while ((dirptr = readdir(dir)) != NULL) {
-		if (dirptr->d_name[0] == '.')
+	while ((name = readDirScanner(&scanner, &type)) != NULL) {
+		if (name[0] == '.')
 			continue;
 
-		switch (dirptr->d_type) {
-			case DT_REG:
-				break;
-			case DT_UNKNOWN: {
-				struct stat info;
-
-				if (fstatat(binaryconfigdirfd, dirptr->d_name, &info, AT_SYMLINK_NOFOLLOW) < 0) {
-					goto err;
-				}
+		if (type == DT_UNKNOWN && resolveDirScannerType(&scanner, name, AT_SYMLINK_NOFOLLOW, &type) < 0)
+			goto err;
 
-				if (S_ISREG(info.st_mode))
-					break;
-			}
-			// fallthrough
-			default:
-				continue;
-		}
+		if (type != DT_REG)
+			continue;
 
-		int new_prio = atoi(dirptr->d_name);
+		int new_prio = atoi(name);
 		if (priority_match_func(new_prio, *prio, data) == 1) {
 			*prio = new_prio;
 			free((void*)filename);
-			filename = strdup(dirptr->d_name);
+			filename = statsStrdup(name);
 		}
 	}
 
 	if (errno == 0 && filename == NULL)
 		errno = ENOENT;
 
-	if (errno == 0)
-		retfd = openat(binaryconfigdirfd, filename, 0, O_RDONLY | O_CLOEXEC);
+	if (errno == 0) {
+		retfd = openat(scanner.fd, filename, O_RDONLY | O_CLOEXEC);
+		if (retfd >= 0)
+			STATS_ADD(files_opened, 1);
+		if (retfd >= 0 && file != NULL && (size_t)snprintf(file->path, sizeof(file->path), "%s/%s", path, filename) >= sizeof(file->path)) {
+			close(retfd);
+			retfd = -1;
+			errno = ENAMETOOLONG;
+		}
+	}
 
 err:
 	saved_error = errno;
 
-	if (configdirfd != -1)
-		close(configdirfd);
-	if (binaryconfigdirfd != -1)
-		close(binaryconfigdirfd);
-	if (dir != NULL)
-		closedir(dir);
+	closeDirScanner(&scanner);
 
 	free((void*)filename);
 	errno = saved_error;
 
+	PROBE3(find_config__return, binary_name, *prio, retfd);
 	return retfd;
 }
 
-static int loadAlternativeForBinary(const char *binary_name, PriorityMatchFunction matcher, int *prio, struct AlternativeLink **alternatives)
+// probes the canonical <prio>.conf name, so that an exact priority does
+// not need to scan the entire binary directory. Like findAltConfig(), only
+// regular files are considered.
+static int openExactAltConfig(const char *binary_name, PriorityMatchFunction matcher, int prio, struct stat *stat_data)
 {
-	struct OptionsParserState *state = NULL;
+	char path[PATH_MAX];
+	int fd;
+
+	if (matcher != PriorityMatch_getExact || prio <= 0)
+		return -1;
+
+	if ((size_t)snprintf(path, sizeof(path), "%s/%s/%d.conf", getConfigDirectory(), binary_name, prio) >= sizeof(path))
+		return -1;
+
+	fd = open(path, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	STATS_ADD(files_opened, 1);
+
+	if (fstat(fd, stat_data) < 0 || !S_ISREG(stat_data->st_mode)) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+// file, if not NULL, is set to the parsed options file on success
+static int loadAlternativeForBinary(const char *binary_name, PriorityMatchFunction matcher, int *prio, struct AlternativeLink **alternatives, struct OptionsFileStamp *file)
+{
+	struct stat stat_data;
+	char buffer[10240];
+	ssize_t size = 0;
 	int ret = -1;
 	int fd = -1;
 
 	*alternatives = NULL;
+	PROBE2(load_binary__entry, binary_name, *prio);
 
-	{
+	TRACE_BEGIN(TRACE_DIRECTORY_SCAN);
+	fd = openExactAltConfig(binary_name, matcher, *prio, &stat_data);
+	if (fd >= 0 && file != NULL)
+		snprintf(file->path, sizeof(file->path), "%s/%s/%d.conf", getConfigDirectory(), binary_name, *prio);
+	if (fd < 0) {
 		int data = *prio;
-		fd = findAltConfig(binary_name, matcher, prio, &data);
-		if (fd < 0)
+		fd = findAltConfig(binary_name, matcher, prio, &data, file);
+		if (fd < 0 || fstat(fd, &stat_data) < 0) {
+			TRACE_END(TRACE_DIRECTORY_SCAN);
 			goto err;
+		}
 	}
+	TRACE_END(TRACE_DIRECTORY_SCAN);
 
-	state = initOptionsParser();
-
-	struct stat stat_data;
-
-	if (fstat(fd, &stat_data) < 0)
-		goto err;
-
-	if (stat_data.st_size > 10240) {
+	TRACE_BEGIN(TRACE_OPTIONS_PARSE);
+	if (stat_data.st_size > (off_t)sizeof(buffer)) {
 		fprintf(stderr, "options file with priority %d is unusually large. Truncating to 10kB", *prio);
-		stat_data.st_size = 10240;
+		stat_data.st_size = sizeof(buffer);
 	}
 
-	char buffer[1024];
-
-	ret = 0;
-	while (ret == 0 && stat_data.st_size > 0) {
-		ssize_t s = read(fd, buffer, 1024);
-		if (s > 0) {
-			ret = parseOptionsData(buffer, s, state);
-			stat_data.st_size -= s;
-		}
+	// read whole, the links are parsed into a single allocation
+	while (size < stat_data.st_size) {
+		ssize_t s = read(fd, buffer + size, stat_data.st_size - size);
+		if (s > 0)
+			size += s;
 		else if (s == 0) {
 			fprintf(stderr, "options file with priority %d changed during reading?", *prio);
-			break;
+			TRACE_END(TRACE_OPTIONS_PARSE);
+			goto err;
 		}
-		else {
-			switch (errno) {
-				case EINTR:
-					continue;
-				default:
-					goto err;
-			}
+		else if (errno != EINTR) {
+			TRACE_END(TRACE_OPTIONS_PARSE);
+			goto err;
 		}
 	}
 
-	if (stat_data.st_size != 0)
-		ret = -1;
+	STATS_ADD(bytes_parsed, size);
+	ret = parseOptionsBuffer(buffer, size, *prio, alternatives);
+	TRACE_END(TRACE_OPTIONS_PARSE);
 
-	if (ret == 0) {
-		*alternatives = doneOptionsParser(*prio, state);
-		state = NULL;
+	if (ret == 0 && file != NULL) {
+		file->ino = stat_data.st_ino;
+		file->size = stat_data.st_size;
+		file->ctime = stat_data.st_ctim;
 	}
 
 err:
-	if (state != NULL) {
-		struct AlternativeLink *tmp = doneOptionsParser(*prio, state);
-		if (tmp != NULL)
-			libalts_free_alternatives_ptr(&tmp);
-	}
-
 	if (fd != -1)
 		close(fd);
 
+	PROBE3(load_binary__return, binary_name, *prio, ret);
+	return ret;
+}
+
+static int loadHighestPriority(const char *binary_name, struct AlternativeLink **alternatives, struct OptionsFileStamp *file)
+{
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
+	int prio = 0;
+	const int ret = loadAlternativeForBinary(binary_name, PriorityMatch_highest, &prio, alternatives, file);
+	CAPTURE_END(LIBALTS_STATS_LOAD_HIGHEST_PRIORITY, binary_name, 0, ret);
+	STATS_END(LIBALTS_STATS_LOAD_HIGHEST_PRIORITY);
+	return ret;
+}
+
+static int loadExactPriority(const char *binary_name, int prio, struct AlternativeLink **alternatives, struct OptionsFileStamp *file)
+{
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
+	const int ret = loadAlternativeForBinary(binary_name, PriorityMatch_getExact, &prio, alternatives, file);
+	CAPTURE_END(LIBALTS_STATS_LOAD_EXACT_PRIORITY, binary_name, prio, ret);
+	STATS_END(LIBALTS_STATS_LOAD_EXACT_PRIORITY);
 	return ret;
 }
 
 PUBLIC_FUNC
 int libalts_load_highest_priority_binary_alternatives(const char *binary_name, struct AlternativeLink **alternatives)
 {
-	int prio = 0;
-	return loadAlternativeForBinary(binary_name, PriorityMatch_highest, &prio, alternatives);
+	return loadHighestPriority(binary_name, alternatives, NULL);
 }
 
 PUBLIC_FUNC
 int libalts_load_exact_priority_binary_alternatives(const char *binary_name, int prio, struct AlternativeLink **alternatives)
 {
-	return loadAlternativeForBinary(binary_name, PriorityMatch_getExact, &prio, alternatives);
+	return loadExactPriority(binary_name, prio, alternatives, NULL);
 }
 
 static int isDotPseudoDirectory(const char *name)
@@ -296,68 +350,54 @@ static int isDotPseudoDirectory(const char *name)
 PUBLIC_FUNC
 int libalts_load_available_binaries(char ***binaries_ptr, size_t *size)
 {
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
 	errno = 0;
 	*size = 0;
 	*binaries_ptr = NULL;
 
 	int saved_error = 0;
 	int ret = -1;
-	int fd = -1;
-	DIR *dir = NULL;
-
-	fd = open(getConfigDirectory(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
-	if (fd == -1)
-		goto err;
-
-	dir = fdopendir(fd);
-	if (dir == NULL) {
-		close(fd);
-		goto err;
-	}
-
+	struct DirScanner scanner;
+	const char *name;
+	unsigned char type;
 	size_t pos = 0;
 
-	struct dirent *dirent;
+	if (openDirScanner(&scanner, AT_FDCWD, getConfigDirectory()) < 0)
+		goto err;
 
-	while ((dirent = readdir(dir)) != NULL) {
+	while ((name = readDirScanner(&scanner, &type)) != NULL) {
 		if (pos >= *size) {
 			*size = 2 * (*size + 1);
-			*binaries_ptr = (char**)realloc(*binaries_ptr, sizeof(char*)**size);
+			*binaries_ptr = (char**)statsRealloc(*binaries_ptr, sizeof(char*)**size);
 		}
 		if (*binaries_ptr == NULL)
 			goto err;
 
-		switch (dirent->d_type) {
-			case DT_DIR:
-				break;
-			case DT_UNKNOWN: {
-				// fall-back to detect directory via stat
-				struct stat st;
-				if (fstatat(fd, dirent->d_name, &st, 0) == -1)
-					goto err;
+		// fall-back to detect directory via stat
+		if (type == DT_UNKNOWN && resolveDirScannerType(&scanner, name, 0, &type) < 0)
+			goto err;
 
-				if (S_ISDIR(st.st_mode))
-					break;
-			}
-			// fall-through
-			default:
-				// skip all non-directories
-				continue;
-		}
-		if (isDotPseudoDirectory(dirent->d_name))
+		// skip all non-directories
+		if (type != DT_DIR)
 			continue;
 
-		(*binaries_ptr)[pos++] = strdup(dirent->d_name);
+		if (isDotPseudoDirectory(name))
+			continue;
+
+		(*binaries_ptr)[pos++] = statsStrdup(name);
 	}
 
+	if (errno != 0)
+		goto err;
+
 	*size = pos;
 	ret = 0;
 
 err:
 	saved_error = errno;
 
-	if (dir != NULL)
-		closedir(dir);
+	closeDirScanner(&scanner);
 	if (ret != 0 && *binaries_ptr != NULL) {
 		size_t i;
 		for(i = 0; i < pos; i++)
@@ -369,6 +409,8 @@ err:
 	if (ret != 0)
 		errno = saved_error;
 
+	CAPTURE_END(LIBALTS_STATS_LOAD_AVAILABLE_BINARIES, NULL, 0, ret);
+	STATS_END(LIBALTS_STATS_LOAD_AVAILABLE_BINARIES);
 	return ret;
 }
 
@@ -385,7 +427,7 @@ int collectAllPrioritiesInData(int new_prio, __attribute__((unused)) int old_pri
 
 	if (data->pos >= *data->size) {
 		*data->size += 32;
-		*data->alts = (int*)realloc(*data->alts, sizeof(int)**data->size);
+		*data->alts = (int*)statsRealloc(*data->alts, sizeof(int)**data->size);
 	}
 
 	(*data->alts)[data->pos++] = new_prio;
@@ -395,20 +437,25 @@ int collectAllPrioritiesInData(int new_prio, __attribute__((unused)) int old_pri
 PUBLIC_FUNC
 int libalts_load_binary_priorities(const char *binary_name, int **alts, size_t *size)
 {
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
 	int ignored;
 
 	*size = 0;
 	*alts = NULL;
 
 	struct collectPrioData data = {alts, size, 0};
-	int fd = findAltConfig(binary_name, collectAllPrioritiesInData, &ignored, &data);
+	int fd = findAltConfig(binary_name, collectAllPrioritiesInData, &ignored, &data, NULL);
 	*size = data.pos;
 
-	if (fd < 0)
-		return fd;
+	if (fd >= 0) {
+		close(fd);
+		fd = 0;
+	}
 
-	close(fd);
-	return 0;
+	CAPTURE_END(LIBALTS_STATS_LOAD_BINARY_PRIORITIES, binary_name, 0, fd);
+	STATS_END(LIBALTS_STATS_LOAD_BINARY_PRIORITIES);
+	return fd;
 }
 
 static ssize_t loadConfigData(const char *config_path, char *data, const ssize_t max_config_size)
@@ -419,6 +466,7 @@ static ssize_t loadConfigData(const char *config_path, char *data, const ssize_t
 	fd = open(config_path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
 	if (fd < 0)
 		goto end;
+	STATS_ADD(files_opened, 1);
 
 	struct stat stat_data;
 	if (fstat(fd, &stat_data) < 0) {
@@ -433,7 +481,7 @@ static ssize_t loadConfigData(const char *config_path, char *data, const ssize_t
 
 	if (stat_data.st_size >= max_config_size) {
 		fprintf(stderr, "ignoring libalternatives config file: %s. Too large.\n", config_path);
-		ret = 0;
+		errno = EFBIG;
 		goto end;
 	}
 
@@ -459,6 +507,7 @@ static ssize_t loadConfigData(const char *config_path, char *data, const ssize_t
 		}
 	}
 	data[ret] = '\x00';
+	STATS_ADD(bytes_parsed, ret);
 
 end:
 	if (fd != -1)
@@ -471,32 +520,81 @@ end:
 PUBLIC_FUNC
 int libalts_read_binary_configured_priority_from_file(const char *binary_name, const char *config_path)
 {
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
 	const ssize_t max_config_size = 1 << 10;
 	char data[max_config_size];
 	data[0] = '\0';
+	PROBE2(read_override__entry, binary_name, config_path);
 	loadConfigData(config_path, data, max_config_size);
 
 	struct ConfigParserState *state = initConfigParser(binary_name);
 	int prio = parseConfigData(data, state);
 	doneConfigParser(state);
+	PROBE3(read_override__return, binary_name, config_path, prio);
+	CAPTURE_END(LIBALTS_STATS_READ_PRIORITY_FROM_FILE, binary_name, 0, prio);
+	STATS_END(LIBALTS_STATS_READ_PRIORITY_FROM_FILE);
 	return prio;
 }
 
+// serializes writers of the override at config_path with a lock of its
+// directory, so that no update is lost. The override itself is replaced
+// by every write, and the directory exists as long as it can be written,
+// so no lock file is left behind. Released on close. Best effort, a lock
+// that cannot be taken, eg. on some network file systems, leaves the
+// writes unserialized, as they were before.
+static int lockOverride(const char *config_path)
+{
+	char dir_path[PATH_MAX] = ".";
+	const char *slash = strrchr(config_path, '/');
+	int fd;
+
+	if (slash != NULL) {
+		const size_t len = (slash == config_path ? 1 : (size_t)(slash - config_path));
+		if (len >= sizeof(dir_path))
+			return -1;
+		memcpy(dir_path, config_path, len);
+		dir_path[len] = '\0';
+	}
+
+	fd = open(dir_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+
+	while (flock(fd, LOCK_EX) < 0) {
+		if (errno != EINTR) {
+			close(fd);
+			return -1;
+		}
+	}
+	return fd;
+}
+
 static int saveConfigData(const char *config_path, const char *data)
 {
-	const char *saved_path = concat_str_safe(config_path, strlen(config_path), ".new", 5);
+	char *saved_path = NULL;
 	mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
 	struct stat st;
 	const size_t len = strlen(data);
 	int ret = 0;
 	int olderr;
 	size_t pos;
+	int fd = -1;
 
+	PROBE1(save_override__entry, config_path);
 	if (stat(config_path, &st) == 0) {
 		mode = st.st_mode & (S_IRWXO | S_IRWXG | S_IRWXU);
 	}
-	int fd = open(saved_path, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, mode);
-	if (fd < 0) {
+
+	// a temporary file of its own, so that a left over one of a crashed
+	// writer is never renamed
+	if (statsAsprintf(&saved_path, "%s.XXXXXX", config_path) < 0) {
+		saved_path = NULL;
+		ret = -1;
+		goto ret;
+	}
+	fd = mkostemp(saved_path, O_CLOEXEC);
+	if (fd < 0 || fchmod(fd, mode) < 0) {
 		ret = -1;
 		goto ret;
 	}
@@ -530,43 +628,185 @@ static int saveConfigData(const char *config_path, const char *data)
 
 ret:
 	olderr = errno;
-	free((void*)saved_path);
+	if (fd != -1)
+		close(fd);
+	if (ret != 0 && saved_path != NULL)
+		unlink(saved_path);
+	free(saved_path);
 	errno = olderr;
+	PROBE2(save_override__return, config_path, ret);
+	return ret;
+}
+
+// next to the system override that it covers, as the configuration
+// directory may be on a read-only file system
+#define GENERATION_FILENAME CONFIG_FILENAME ".generation"
+#define GENERATION_PATH ETC_PATH "/" GENERATION_FILENAME
+
+static int readGeneration(int fd, unsigned long long *generation)
+{
+	char data[32];
+	ssize_t len;
+
+	do {
+		len = read(fd, data, sizeof(data)-1);
+	} while (len < 0 && errno == EINTR);
+
+	if (len < 0)
+		return -1;
+
+	data[len] = '\0';
+	*generation = strtoull(data, NULL, 10);
+	return 0;
+}
+
+static int bumpGeneration()
+{
+	const char tmp_filename[] = GENERATION_FILENAME ".new";
+	unsigned long long generation = 0;
+	int dirfd = -1, fd = -1, is_tmp_created = 0;
+	int ret = -1;
+	int saved_error;
+	char data[32];
+
+	dirfd = open(ETC_PATH, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dirfd < 0)
+		goto err;
+
+	// serializes writers, so no bump is lost. Released on close.
+	while (flock(dirfd, LOCK_EX) < 0) {
+		if (errno != EINTR)
+			goto err;
+	}
+
+	fd = openat(dirfd, GENERATION_FILENAME, O_RDONLY | O_CLOEXEC);
+	if (fd >= 0) {
+		readGeneration(fd, &generation);
+		close(fd);
+	}
+
+	const int len = snprintf(data, sizeof(data), "%llu\n", generation + 1);
+
+	fd = openat(dirfd, tmp_filename, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fd < 0)
+		goto err;
+	is_tmp_created = 1;
+
+	if (write(fd, data, len) != len)
+		goto err;
+
+	ret = close(fd);
+	fd = -1;
+	if (ret == 0)
+		ret = renameat(dirfd, tmp_filename, dirfd, GENERATION_FILENAME);
+
+err:
+	saved_error = errno;
+	if (ret != 0 && is_tmp_created)
+		unlinkat(dirfd, tmp_filename, 0);
 	if (fd != -1)
 		close(fd);
+	if (dirfd != -1)
+		close(dirfd);
+	errno = saved_error;
+	return ret;
+}
+
+PUBLIC_FUNC
+int libalts_bump_generation()
+{
+	return bumpGeneration();
+}
+
+PUBLIC_FUNC
+int libalts_get_generation(unsigned long long *generation)
+{
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
+	int fd = open(libalts_get_generation_path(), O_RDONLY | O_CLOEXEC);
+	int ret;
+
+	*generation = 0;
+	if (fd >= 0) {
+		STATS_ADD(files_opened, 1);
+		ret = readGeneration(fd, generation);
+		close(fd);
+	}
+	else {
+		ret = errno == ENOENT ? 0 : -1;
+	}
+
+	CAPTURE_END(LIBALTS_STATS_GET_GENERATION, NULL, 0, ret);
+	STATS_END(LIBALTS_STATS_GET_GENERATION);
 	return ret;
 }
 
+PUBLIC_FUNC
+const char* libalts_get_generation_path()
+{
+	return GENERATION_PATH;
+}
+
 PUBLIC_FUNC
 int libalts_write_binary_configured_priority_to_file(const char *binary_name, int priority, const char *config_path)
 {
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
 	const ssize_t max_config_size = 1 << 10;
 	char data[max_config_size];
+	struct ConfigParserState *state = NULL;
+	const char *new_data = NULL;
+	int ret = -1;
+
+	// held until the updated config replaced the one it is based on
+	const int lock_fd = lockOverride(config_path);
+
+	// a config that cannot be read would be replaced by the one entry
 	data[0] = '\0';
-	loadConfigData(config_path, data, max_config_size);
+	if (loadConfigData(config_path, data, max_config_size) < 0 && errno != ENOENT)
+		goto err;
 
-	struct ConfigParserState *state = initConfigParser(binary_name);
+	state = initConfigParser(binary_name);
 	parseConfigData(data, state);
-	const char *new_data;
 	if (priority == 0)
 		new_data = resetToDefaultPriorityAndReturnUpdatedConfig(state);
 	else
 		new_data = setBinaryPriorityAndReturnUpdatedConfig(priority, state);
 
-	int ret = -1;
-
 	if (new_data != NULL)
 		ret = saveConfigData(config_path, new_data);
 
+err:
+	if (lock_fd >= 0) {
+		const int saved_error = errno;
+		close(lock_fd);
+		errno = saved_error;
+	}
+
+	// only the system override is part of the configuration that the
+	// generation stands for, users cannot bump it
+	if (ret == 0 && strcmp(config_path, libalts_get_system_config_path()) == 0)
+		ret = bumpGeneration();
+
 	doneConfigParser(state);
+	CAPTURE_END(LIBALTS_STATS_WRITE_PRIORITY_TO_FILE, binary_name, priority, ret);
+	STATS_END(LIBALTS_STATS_WRITE_PRIORITY_TO_FILE);
 	return ret;
 }
 
 PUBLIC_FUNC
 void libalts_free_alternatives_ptr(struct AlternativeLink **links)
 {
-	for (struct AlternativeLink *ptr=*links; ptr != NULL && ptr->type != ALTLINK_EOL; ptr++)
-		free((void*)ptr->target);
+	struct AlternativeLink *eol = *links;
+
+	while (eol != NULL && eol->type != ALTLINK_EOL)
+		eol++;
+
+	// links of the library hold their targets, arrays of callers may not
+	if (eol != NULL && !IS_SINGLE_ALLOCATION(eol)) {
+		for (struct AlternativeLink *ptr = *links; ptr != eol; ptr++)
+			free((void*)ptr->target);
+	}
 
 	free(*links);
 	*links = NULL;
@@ -575,13 +815,17 @@ void libalts_free_alternatives_ptr(struct AlternativeLink **links)
 PUBLIC_FUNC
 int libalts_read_configured_priority(const char *binary_name, int *src)
 {
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
 	// try to load user override
 	const char *config_path = libalts_get_user_config_path();
 	int priority = 0;
 	if (config_path != NULL) {
 		if (IS_DEBUG)
 			fprintf(stderr, "Trying to load user override for %s from: %s\n", binary_name, config_path);
+		TRACE_BEGIN(TRACE_USER_CONFIG);
 		priority = libalts_read_binary_configured_priority_from_file(binary_name, config_path);
+		TRACE_END(TRACE_USER_CONFIG);
 		if (IS_DEBUG)
 			fprintf(stderr, "user override priority: %d\n", priority);
 		if (unlikely(src != NULL)) {
@@ -593,7 +837,9 @@ int libalts_read_configured_priority(const char *binary_name, int *src)
 
 	// if not loaded, try system override
 	if (priority <= 0) {
+		TRACE_BEGIN(TRACE_SYSTEM_CONFIG);
 		priority = libalts_read_binary_configured_priority_from_file(binary_name, SYSTEM_OVERRIDE_PATH);
+		TRACE_END(TRACE_SYSTEM_CONFIG);
 		if (IS_DEBUG)
 			fprintf(stderr, "system override priority: %d\n", priority);
 		if (unlikely(src != NULL)) {
@@ -603,6 +849,8 @@ int libalts_read_configured_priority(const char *binary_name, int *src)
 		}
 	}
 
+	CAPTURE_END(LIBALTS_STATS_READ_CONFIGURED_PRIORITY, binary_name, 0, priority);
+	STATS_END(LIBALTS_STATS_READ_CONFIGURED_PRIORITY);
 	return priority;
 }
 
@@ -641,16 +889,33 @@ void setConfigPath(const char *config_path)
 
 	__override_path = NULL;
 	if (config_path)
-		__override_path = strdup(config_path);
+		__override_path = statsStrdup(config_path);
 }
 
-static int loadAlternatives(const char *binary_name, struct AlternativeLink **alts)
+// file, if not NULL, is set to the options file that alts were loaded from
+static int loadAlternatives(const char *binary_name, struct AlternativeLink **alts, struct OptionsFileStamp *file)
 {
+#ifdef USE_ALTSD
+	// user overrides are not known to the daemon, and options files are
+	// not known to its clients
+	if (file == NULL) {
+		const char *user_config = libalts_get_user_config_path();
+		TRACE_BEGIN(TRACE_USER_CONFIG);
+		const int user_priority = (user_config != NULL ? libalts_read_binary_configured_priority_from_file(binary_name, user_config) : 0);
+		TRACE_END(TRACE_USER_CONFIG);
+		if (queryResolver(binary_name, user_priority, alts) == 0) {
+			if (IS_DEBUG)
+				fprintf(stderr, "loaded alternatives from altsd\n");
+			return 0;
+		}
+	}
+#endif
+
 	int priority = libalts_read_configured_priority(binary_name, NULL);
 
 	int ret = 0;
 	if (priority > 0) {
-		ret = libalts_load_exact_priority_binary_alternatives(binary_name, priority, alts);
+		ret = loadExactPriority(binary_name, priority, alts, file);
 		if (unlikely(ret != 0)) {
 			if (IS_DEBUG)
 				fprintf(stderr, "failed to load override priority %d - reseting to default", priority);
@@ -658,7 +923,7 @@ static int loadAlternatives(const char *binary_name, struct AlternativeLink **al
 		}
 	}
 	if (priority == 0)
-		ret = libalts_load_highest_priority_binary_alternatives(binary_name, alts);
+		ret = loadHighestPriority(binary_name, alts, file);
 
 	if (IS_DEBUG)
 		fprintf(stderr, "loaded alternatives?: %d\n", ret);
@@ -666,51 +931,294 @@ static int loadAlternatives(const char *binary_name, struct AlternativeLink **al
 	return ret;
 }
 
+static void getInheritPaths(struct InheritPaths *paths)
+{
+	paths->config_dir = getConfigDirectory();
+	paths->system_config = SYSTEM_OVERRIDE_PATH;
+	paths->user_config = libalts_get_user_config_path();
+}
+
+static const struct AlternativeLink* findBinaryLink(const struct AlternativeLink *alts)
+{
+	for (; alts != NULL && alts->type != ALTLINK_EOL; alts++) {
+		if (alts->type == ALTLINK_BINARY)
+			return alts;
+	}
+
+	return NULL;
+}
+
+#ifdef USE_EXECVEAT
+extern char **environ;
+
+// executes exactly the inode that target resolves to now, so the kernel
+// does not walk the path again. Returns -1 if path based exec should be
+// tried instead, or 0 if target cannot be executed.
+static int execTargetFd(const char *target, char *argv[])
+{
+	const int fd = open(target, O_PATH | O_CLOEXEC);
+	if (fd < 0)
+		return 0;
+
+	syscall(SYS_execveat, fd, "", argv, environ, AT_EMPTY_PATH);
+
+	// script interpreters cannot open the close-on-exec fd and the kernel
+	// reports ENOENT. Older kernels lack execveat() altogether.
+	const int saved_error = errno;
+	close(fd);
+	errno = saved_error;
+	return errno == ENOENT || errno == ENOSYS ? -1 : 0;
+}
+#endif
+
+// source of the target for the trace
+static void execTarget(const char *target, int options, char *argv[], const char *source)
+{
+	if ((options & ALTLINK_OPTIONS_KEEPARGV0) == 0)
+		argv[0] = (char*)target;
+	if (unlikely(libalternatives_trace)) {
+		endTracePhase(TRACE_PRE_EXEC);
+		emitTrace(target, source);
+	}
+#ifdef USE_EXECVEAT
+	if (execTargetFd(target, argv) == 0) {
+		perror("Failed to execute target.");
+		return;
+	}
+#endif
+	execv(target, argv);
+	perror("Failed to execute target.");
+}
+
 PUBLIC_FUNC
 int libalts_exec_default(char *argv[])
 {
+	STATS_ADD(functions[LIBALTS_STATS_EXEC_DEFAULT].calls, 1);
+	CAPTURE_BEGIN();
 	argv[0]=basename(argv[0]);
 
 	struct AlternativeLink *alts;
+	struct InheritPaths inherit_paths;
+	struct OptionsFileStamp file;
+	const int is_inherited_cache = isInheritedCacheEnabled();
 	checkEnvDebug();
-	loadAlternatives(argv[0], &alts);
+	startTrace(argv[0]);
 
-	if (alts) {
-		while (alts->type != ALTLINK_EOL) {
-			if (alts->type == ALTLINK_BINARY) {
-				if ((alts->options & ALTLINK_OPTIONS_KEEPARGV0) == 0)
-					argv[0] = (char*)alts->target;
-				execv(alts->target, argv);
-				perror("Failed to execute target.");
-				break;
-			}
-			alts++;
+	if (unlikely(is_inherited_cache)) {
+		char *target;
+		int options;
+
+		getInheritPaths(&inherit_paths);
+		if (lookupInheritedCache(&inherit_paths, argv[0], &target, &options) == 0) {
+			if (IS_DEBUG)
+				fprintf(stderr, "using inherited target %s\n", target);
+			TRACE_BEGIN(TRACE_PRE_EXEC);
+			PROBE3(exec, argv[0], target, 0);
+			countUsage(USAGE_PATH, argv[0], 0);
+			CAPTURE_END(LIBALTS_STATS_EXEC_DEFAULT, argv[0], 0, 0);
+			execTarget(target, options, argv, "cache");
+			free(target);
+			errno = ENOENT;
+			return -1;
 		}
 	}
 
+	// the cache needs the options file, which altsd does not report
+	loadAlternatives(argv[0], &alts, unlikely(is_inherited_cache) ? &file : NULL);
+
+	const struct AlternativeLink *binary = findBinaryLink(alts);
+	if (binary) {
+		TRACE_BEGIN(TRACE_PRE_EXEC);
+		if (unlikely(is_inherited_cache))
+			exportInheritedCache(&inherit_paths, argv[0], &file, binary->target, binary->options);
+		PROBE3(exec, argv[0], binary->target, binary->priority);
+		countUsage(USAGE_PATH, argv[0], binary->priority);
+		CAPTURE_END(LIBALTS_STATS_EXEC_DEFAULT, argv[0], 0, 0);
+		execTarget(binary->target, binary->options, argv, "config");
+	}
+	else {
+		if (unlikely(libalternatives_trace))
+			emitTrace(NULL, "none");
+		CAPTURE_END(LIBALTS_STATS_EXEC_DEFAULT, argv[0], 0, -1);
+	}
+
 	if (IS_DEBUG)
-		fprintf(stderr, "execDefault() failed with target %s\n", (alts ? alts->target : NULL));
+		fprintf(stderr, "execDefault() failed with target %s\n", (binary ? binary->target : NULL));
 	if (alts)
 		libalts_free_alternatives_ptr(&alts);
 	errno = ENOENT;
 	return -1;
 }
 
+PUBLIC_FUNC
+int libalts_export_inherited_cache(const char *binary_name)
+{
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
+	struct AlternativeLink *alts;
+	struct InheritPaths inherit_paths;
+	struct OptionsFileStamp file;
+	int ret = -1;
+
+	loadAlternatives(binary_name, &alts, &file);
+
+	const struct AlternativeLink *binary = findBinaryLink(alts);
+	if (binary) {
+		getInheritPaths(&inherit_paths);
+		ret = exportInheritedCache(&inherit_paths, binary_name, &file, binary->target, binary->options);
+	}
+	else {
+		errno = ENOENT;
+	}
+
+	if (alts)
+		libalts_free_alternatives_ptr(&alts);
+	CAPTURE_END(LIBALTS_STATS_EXPORT_INHERITED_CACHE, binary_name, 0, ret);
+	STATS_END(LIBALTS_STATS_EXPORT_INHERITED_CACHE);
+	return ret;
+}
+
+PUBLIC_FUNC
+int libalts_resolve_default_binary(const char *binary_name, char **target, int *options)
+{
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
+	struct AlternativeLink *alts;
+	int ret = -1;
+
+	checkEnvDebug();
+	loadAlternatives(binary_name, &alts, NULL);
+
+	const struct AlternativeLink *binary = findBinaryLink(alts);
+	if (binary) {
+		*target = statsStrdup(binary->target);
+		*options = binary->options;
+		ret = (*target != NULL ? 0 : -1);
+	}
+	else {
+		errno = ENOENT;
+	}
+
+	if (alts)
+		libalts_free_alternatives_ptr(&alts);
+	CAPTURE_END(LIBALTS_STATS_RESOLVE_DEFAULT_BINARY, binary_name, 0, ret);
+	STATS_END(LIBALTS_STATS_RESOLVE_DEFAULT_BINARY);
+	return ret;
+}
+
+static void setLauncherStamp(struct LauncherStamp *stamp, const struct timespec *ts)
+{
+	stamp->sec = ts->tv_sec;
+	stamp->nsec = ts->tv_nsec;
+}
+
+// returns 1 if any of the timestamps is too recent to be trusted
+static int getLauncherStamps(struct LauncherData *data, const struct timespec *now)
+{
+	struct timespec binary_dir, system_config, user_config;
+
+	if (getModificationTime(data->binary_dir, &binary_dir) < 0 ||
+	    getModificationTime(data->system_config, &system_config) < 0 ||
+	    getModificationTime(data->user_config[0] != '\0' ? data->user_config : NULL, &user_config) < 0)
+		return -1;
+
+	setLauncherStamp(&data->binary_dir_stamp, &binary_dir);
+	setLauncherStamp(&data->system_config_stamp, &system_config);
+	setLauncherStamp(&data->user_config_stamp, &user_config);
+
+	return isRecentModificationTime(&binary_dir, now) ||
+	       isRecentModificationTime(&system_config, now) ||
+	       isRecentModificationTime(&user_config, now);
+}
+
+PUBLIC_FUNC
+int libalts_generate_launcher(const char *binary_name, const char *launcher_path)
+{
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
+	struct AlternativeLink *alts = NULL;
+	struct LauncherData *data = statsCalloc(1, sizeof(struct LauncherData));
+	struct OptionsFileStamp file;
+	const char *user_config = libalts_get_user_config_path();
+	int ret = -1;
+
+	if (data == NULL)
+		goto err;
+
+	memcpy(data->magic, LAUNCHER_MAGIC, sizeof(LAUNCHER_MAGIC));
+	if ((size_t)snprintf(data->binary_name, sizeof(data->binary_name), "%s", binary_name) >= sizeof(data->binary_name) ||
+	    (size_t)snprintf(data->fallback, sizeof(data->fallback), "%s", ALTS_BINARY_PATH) >= sizeof(data->fallback) ||
+	    (size_t)snprintf(data->binary_dir, sizeof(data->binary_dir), "%s/%s", getConfigDirectory(), binary_name) >= sizeof(data->binary_dir) ||
+	    (size_t)snprintf(data->system_config, sizeof(data->system_config), "%s", SYSTEM_OVERRIDE_PATH) >= sizeof(data->system_config) ||
+	    (size_t)snprintf(data->user_config, sizeof(data->user_config), "%s", user_config ? user_config : "") >= sizeof(data->user_config)) {
+		errno = ENAMETOOLONG;
+		goto err;
+	}
+
+	// stamps are taken before resolving, so a change while resolving makes
+	// the launcher stale. The options file is stamped when it is read.
+	// Wait out changes that are too recent to detect.
+	for (;;) {
+		struct timespec now;
+		int is_recent;
+
+		if (clock_gettime(CLOCK_REALTIME, &now) < 0 || (is_recent = getLauncherStamps(data, &now)) < 0)
+			goto err;
+		if (!is_recent) {
+			if (loadAlternatives(binary_name, &alts, &file) != 0 || !isRecentModificationTime(&file.ctime, &now))
+				break;
+			libalts_free_alternatives_ptr(&alts);
+		}
+
+		const struct timespec delay = { 0, 100000000 };
+		nanosleep(&delay, NULL);
+	}
+
+	const struct AlternativeLink *binary = findBinaryLink(alts);
+	if (binary == NULL) {
+		errno = ENOENT;
+		goto err;
+	}
+
+	if ((size_t)snprintf(data->target, sizeof(data->target), "%s", binary->target) >= sizeof(data->target)) {
+		errno = ENAMETOOLONG;
+		goto err;
+	}
+	data->options = binary->options;
+	memcpy(data->options_file, file.path, sizeof(data->options_file));
+	data->options_file_ino = file.ino;
+	data->options_file_size = file.size;
+	setLauncherStamp(&data->options_file_ctime, &file.ctime);
+
+	ret = writeLauncher(LAUNCHER_TEMPLATE_PATH, launcher_path, data);
+
+err:
+	if (alts)
+		libalts_free_alternatives_ptr(&alts);
+	free(data);
+	CAPTURE_END(LIBALTS_STATS_GENERATE_LAUNCHER, binary_name, 0, ret);
+	STATS_END(LIBALTS_STATS_GENERATE_LAUNCHER);
+	return ret;
+}
+
+#ifndef LIBALTS_EXEC_ONLY
 PUBLIC_FUNC
 char** libalts_get_default_manpages(const char *binary_name)
 {
+	STATS_BEGIN();
+	CAPTURE_BEGIN();
 	struct AlternativeLink *alts;
 	checkEnvDebug();
-	loadAlternatives(binary_name, &alts);
+	loadAlternatives(binary_name, &alts, NULL);
 
 	size_t size = 16, pos = 0;
-	char **manpages = malloc(sizeof(char*)*size);
+	char **manpages = statsMalloc(sizeof(char*)*size);
 
 	if (alts) {
 		struct AlternativeLink *ptr = alts;
 		while (ptr->type != ALTLINK_EOL && pos < size-1) {
 			if (ptr->type == ALTLINK_MANPAGE)
-				manpages[pos++] = strdup(ptr->target);
+				manpages[pos++] = statsStrdup(ptr->target);
 			ptr++;
 		}
 
@@ -718,5 +1226,46 @@ char** libalts_get_default_manpages(const char *binary_name)
 	}
 
 	manpages[pos] = NULL;
+	CAPTURE_END(LIBALTS_STATS_GET_DEFAULT_MANPAGES, binary_name, 0, (int)pos);
+	STATS_END(LIBALTS_STATS_GET_DEFAULT_MANPAGES);
 	return manpages;
 }
+#endif
+
+PUBLIC_FUNC
+int libalts_reset_usage()
+{
+	return resetUsage(USAGE_PATH);
+}
+
+PUBLIC_FUNC
+const char* libalts_get_usage_path()
+{
+	return USAGE_PATH;
+}
+
+PUBLIC_FUNC
+int libalts_load_usage(struct LibaltsUsage **usage, size_t *size)
+{
+	return loadUsage(USAGE_PATH, usage, size);
+}
+
+PUBLIC_FUNC
+int libalts_get_stats(struct LibaltsStats *stats, size_t size)
+{
+	struct LibaltsStats snapshot;
+	const unsigned long long *counters = (const unsigned long long*)&libalternatives_stats;
+	unsigned long long *copy = (unsigned long long*)&snapshot;
+
+	if (stats == NULL || size > sizeof(snapshot)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	// the structure only holds counters, which are read one by one
+	for (size_t i=0; i<sizeof(snapshot)/sizeof(*copy); i++)
+		copy[i] = __atomic_load_n(counters + i, __ATOMIC_RELAXED);
+
+	memcpy(stats, &snapshot, size);
+	return 0;
+}
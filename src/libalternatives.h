@@ -57,6 +57,8 @@ int libalts_load_binary_priorities(const char *binary_name, int **alts, size_t *
 // 0 otherwise, or -1 on error
 int libalts_read_binary_configured_priority_from_file(const char *binary_name, const char *config_path);
 
+// writing the system override bumps the generation. If that fails, the
+// override is written, but -1 is returned.
 // return 0 on success and -1 on error
 int libalts_write_binary_configured_priority_to_file(const char *binary_name, int priority, const char *config_path);
 
@@ -69,16 +71,119 @@ int libalts_read_configured_priority(const char *binary_name, int *src);
 const char* libalts_get_system_config_path();
 const char* libalts_get_user_config_path();
 
-// convenience
+// convenience, frees the links along with their targets. Links returned
+// by the library share one allocation with their targets. Arrays built by
+// the caller, ending with a NULL target, may hold targets allocated one by
+// one, which are freed as well.
 void libalts_free_alternatives_ptr(struct AlternativeLink **);
 
 // convenience
 int libalts_exec_default(char *argv[]); // binary in argv[0]
 
+// target and options that libalts_exec_default() would execute
+// return 0 and allocated target on success and -1 on error
+int libalts_resolve_default_binary(const char *binary_name, char **target, int *options);
+
 // returns a list of manpages followed by a NULL ptr
 // returned data should be freed
 char** libalts_get_default_manpages(const char *binary_name);
 
+// generation counter of the system configuration. It is bumped by writing
+// the system override and by `alts --touch`, which is meant for package
+// scriptlets. Per-user overrides do not bump it, consumers that honor
+// them also compare the mtime of libalts_get_user_config_path().
+// The stamp file next to the system override is replaced on every bump,
+// so a consumer can cache results and revalidate them with a single
+// stat() of its path.
+// return 0 on success and -1 on error. Generation is 0 if never bumped.
+int libalts_get_generation(unsigned long long *generation);
+int libalts_bump_generation();
+const char* libalts_get_generation_path();
+
+// resolves binary_name and adds it to the LIBALTERNATIVES_CACHE
+// environment variable, which enables libalts_exec_default() in
+// descendant processes to exec it without reading the configuration
+// return 0 on success and -1 on error or if it cannot be cached yet
+int libalts_export_inherited_cache(const char *binary_name);
+
+// writes a launcher to launcher_path that executes the current target of
+// binary_name directly, until the configuration changes and it falls back
+// to alts. Waits up to a second if the configuration was just changed.
+// return 0 on success and -1 on error
+int libalts_generate_launcher(const char *binary_name, const char *launcher_path);
+
+struct LibaltsUsage
+{
+	const char *binary_name;
+	int priority; // 0 for executions from the inherited cache
+	unsigned long long count;
+};
+
+// executions through libalts_exec_default() of all processes with
+// LIBALTERNATIVES_USAGE=1 in their environment are counted per binary and
+// priority while the usage file exists. Resetting creates it, or replaces
+// it with an empty one.
+// return 0 on success and -1 on error
+int libalts_reset_usage();
+const char* libalts_get_usage_path();
+
+// loads the counted executions, most frequent first. *usage is a single
+// allocation that should be freed with free().
+// return 0 on success and -1 on error, ENOENT if counting is disabled
+int libalts_load_usage(struct LibaltsUsage **usage, size_t *size);
+
+// public functions with statistics
+enum LibaltsStatsFunction
+{
+	LIBALTS_STATS_LOAD_HIGHEST_PRIORITY = 0,
+	LIBALTS_STATS_LOAD_EXACT_PRIORITY,
+	LIBALTS_STATS_LOAD_AVAILABLE_BINARIES,
+	LIBALTS_STATS_LOAD_BINARY_PRIORITIES,
+	LIBALTS_STATS_READ_PRIORITY_FROM_FILE,
+	LIBALTS_STATS_WRITE_PRIORITY_TO_FILE,
+	LIBALTS_STATS_READ_CONFIGURED_PRIORITY,
+	LIBALTS_STATS_EXEC_DEFAULT, // calls only, it does not return on success
+	LIBALTS_STATS_RESOLVE_DEFAULT_BINARY,
+	LIBALTS_STATS_GET_DEFAULT_MANPAGES,
+	LIBALTS_STATS_GET_GENERATION,
+	LIBALTS_STATS_EXPORT_INHERITED_CACHE,
+	LIBALTS_STATS_GENERATE_LAUNCHER,
+
+	LIBALTS_STATS_FUNCTION_COUNT
+};
+
+// latency[0] counts calls below 1 us, latency[i] calls of at least
+// 2^(i-1) and below 2^i us. The last bucket has all longer calls.
+#define LIBALTS_STATS_LATENCY_BUCKETS 20
+
+struct LibaltsFunctionStats
+{
+	unsigned long long calls;
+	unsigned long long total_ns;
+	unsigned long long latency[LIBALTS_STATS_LATENCY_BUCKETS];
+};
+
+// functions is last, so that later versions can add functions to the
+// end of the structure. Other counters will not be added.
+struct LibaltsStats
+{
+	unsigned long long directories_scanned;
+	unsigned long long files_opened; // configuration and override files
+	unsigned long long bytes_parsed;
+	unsigned long long allocations;
+	struct LibaltsFunctionStats functions[LIBALTS_STATS_FUNCTION_COUNT];
+};
+
+// copies the cumulative statistics of this process since it loaded the
+// library. They are only kept with LIBALTERNATIVES_STATS=1 in the
+// environment of the process, otherwise all counters stay 0. Calls made
+// by the library itself, like libalts_exec_default() reading the
+// overrides, are included. Counters are read one by one while other
+// threads may update them. Pass sizeof(struct LibaltsStats), so that
+// later versions can append functions.
+// return 0 on success and -1 on error
+int libalts_get_stats(struct LibaltsStats *stats, size_t size);
+
 // for unit testing only, remove from library symbols later
 #ifdef UNITTESTS
 void setConfigDirectory(const char *config_directory);
@@ -19,6 +19,7 @@
 
 #include "libalternatives.h"
 #include "parser.h"
+#include "stats.h"
 
 #ifndef MIN
 #define MIN(a,b) ((a<b)?(a):(b))
@@ -34,6 +35,14 @@ struct OptionsParserState
 
 	struct AlternativeLink *parsed_data;
 	int parsed_data_size;
+
+	// targets of parsed_data, one after another. Until the parser is done,
+	// priority of a link holds the offset of its target here
+	char *strings;
+	size_t strings_size, strings_used;
+
+	// parsed_data and strings are one block sized for the whole input
+	int is_fixed;
 };
 
 static int isWhitespace(const char c)
@@ -55,20 +64,43 @@ static int parser_alreadyErrorNoResumePossible(const char *data, size_t len, str
 	return -1;
 }
 
-static void allocateBuffer(struct AlternativeLink **link, int *size_ptr)
+static void clearLinks(struct AlternativeLink *link, int from, int to)
+{
+	for (int i=from; i<to; ++i) {
+		link[i].type = ALTLINK_EOL;
+		link[i].target = 0;
+	}
+}
+
+static int allocateBuffer(struct OptionsParserState *state)
 {
-	int size = *size_ptr;
-	if (*link == NULL || size < 8)
-		size = 0;
-	size += 8;
+	if (state->is_fixed)
+		return -1;
 
-	*link = realloc(*link, sizeof(struct AlternativeLink) * size);
+	const int size = state->parsed_data_size + 8;
+	struct AlternativeLink *link = statsRealloc(state->parsed_data, sizeof(struct AlternativeLink) * size);
+	if (link == NULL)
+		return -1;
 
-	for (int i=*size_ptr; i<size; ++i) {
-		(*link+i)->type = ALTLINK_EOL;
-		(*link+i)->target = 0;
-	}
-	*size_ptr = size;
+	clearLinks(link, state->parsed_data_size, size);
+	state->parsed_data = link;
+	state->parsed_data_size = size;
+	return 0;
+}
+
+static int allocateStrings(struct OptionsParserState *state)
+{
+	if (state->is_fixed)
+		return -1;
+
+	const size_t size = state->strings_size > 0 ? state->strings_size * 2 : 0x100;
+	char *strings = statsRealloc(state->strings, size);
+	if (strings == NULL)
+		return -1;
+
+	state->strings = strings;
+	state->strings_size = size;
+	return 0;
 }
 
 static int findFirstParsedDataLocation(struct OptionsParserState *state, int type)
@@ -84,17 +116,33 @@ static int findFirstParsedDataLocation(struct OptionsParserState *state, int typ
 		}
 	}
 
-	allocateBuffer(&state->parsed_data, &state->parsed_data_size);
+	if (allocateBuffer(state) != 0)
+		return -1;
 	return findFirstParsedDataLocation(state, type);
 }
 
 static int findFirstFreeDataLocation(struct OptionsParserState *state, int type)
 {
 	int pos = findFirstParsedDataLocation(state, ALTLINK_EOL);
-	(state->parsed_data+pos)->type = type;
+	if (pos >= 0)
+		(state->parsed_data+pos)->type = type;
 	return pos;
 }
 
+// trims the value being parsed and makes it the target of the link
+// returns length of the value
+static u_int32_t endValue(struct OptionsParserState *state, struct AlternativeLink *link, u_int32_t value_string_pos)
+{
+	char *out = state->strings + state->strings_used;
+
+	while (value_string_pos > 0 && isWhitespace(out[value_string_pos-1]))
+		value_string_pos--;
+	out[value_string_pos] = '\x00';
+
+	link->priority = state->strings_used;
+	return value_string_pos;
+}
+
 static int parser_parseValue(const char *data, size_t len, struct OptionsParserState *state);
 static int parser_skipOptionalWhitespaceBeforeManpageEntries(const char *data, size_t len, struct OptionsParserState *state)
 {
@@ -115,32 +163,40 @@ static int parser_searchToken(const char *data, size_t len, struct OptionsParser
 static int parser_parseValue(const char *data, size_t len, struct OptionsParserState *state)
 {
 	struct AlternativeLink *link = state->parsed_data + state->parser_func_param;
-	u_int16_t value_string_pos = state->parser_func_param2 & 0xFFFF;
-	u_int16_t value_string_size = state->parser_func_param2 >> 16;
+	u_int32_t value_string_pos = state->parser_func_param2;
 	const int is_multi_value = state->parser_func_param3 & 0x1;
 
 	while (len > 0) {
 		char c = *data;
-		char *out = (char*)link->target;
 
-		if (value_string_pos >= value_string_size) {
-			value_string_size += 0x100;
-			link->target = realloc((void*)link->target, value_string_size);
-			out = (char*)link->target;
+		// no path is that long
+		if (value_string_pos >= 0xFFFF) {
+			state->parser_func = parser_alreadyErrorNoResumePossible;
+			return -1;
 		}
+		// room for c, or the terminating NUL in its place
+		if (state->strings_used + value_string_pos >= state->strings_size && allocateStrings(state) != 0) {
+			state->parser_func = parser_alreadyErrorNoResumePossible;
+			return -1;
+		}
+		char *out = state->strings + state->strings_used;
 
 		switch (c) {
 			case ',':
 				if (is_multi_value) {
-					out[value_string_pos] = '\x00';
-					while (value_string_pos > 0 && isWhitespace(out[value_string_pos-1])) {
-						out[--value_string_pos] = '\x00';
-					}
+					value_string_pos = endValue(state, link, value_string_pos);
 
+					// an empty value is overwritten by the next one
 					if (value_string_pos > 0) {
-						state->parser_func_param = findFirstFreeDataLocation(state, link->type);
-						state->parser_func_param2 = 0;
+						const int pos = findFirstFreeDataLocation(state, link->type);
+						if (pos < 0) {
+							state->parser_func = parser_alreadyErrorNoResumePossible;
+							return -1;
+						}
+						state->strings_used += value_string_pos + 1;
+						state->parser_func_param = pos;
 					}
+					state->parser_func_param2 = 0;
 
 					state->parser_func = parser_skipOptionalWhitespaceBeforeManpageEntries;
 					return state->parser_func(data+1, len-1, state);
@@ -150,11 +206,7 @@ static int parser_parseValue(const char *data, size_t len, struct OptionsParserS
 			case '\n':
 			case '\r':
 			case '\0':
-				out[value_string_pos] = '\x00';
-				while (value_string_pos > 0 && isWhitespace(out[value_string_pos-1])) {
-					out[--value_string_pos] = '\x00';
-				}
-
+				state->strings_used += endValue(state, link, value_string_pos) + 1;
 				state->parser_func = parser_searchToken;
 				return state->parser_func(data+1, len-1, state);
 			default:
@@ -167,7 +219,7 @@ static int parser_parseValue(const char *data, size_t len, struct OptionsParserS
 		value_string_pos++;
 	}
 
-	state->parser_func_param2 = value_string_pos | (((u_int32_t)value_string_size) << 16);
+	state->parser_func_param2 = value_string_pos;
 	return 0;
 }
 
@@ -337,13 +389,18 @@ static int parser_skipOptionalWhiteSpace(const char *data, size_t len, struct Op
 			break;
 	}
 
+	// no room for another link
+	if (state->parser_func_param == (u_int32_t)-1)
+		state->parser_func = parser_alreadyErrorNoResumePossible;
+
 	return state->parser_func(data, len, state);
 }
 
 static int assertTokenMatch(const char *data, size_t len, struct OptionsParserState *state, const char *match, int match_len, int whiteSpace_param)
 {
 	int pos = state->parser_func_param;
-	int end_pos = match_len - pos + 1 <= (int)len ? match_len - pos + 1 : (int)len + pos;
+	// resumes at pos when the token was split between reads
+	int end_pos = match_len - pos <= (int)len ? match_len : (int)len + pos;
 
 	while (pos < end_pos && *data == match[pos]) {
 		data++;
@@ -426,17 +483,77 @@ static int parser_searchToken(const char *data, size_t len, struct OptionsParser
 	return state->parser_func(data+1, len-1, state);
 }
 
-struct OptionsParserState* initOptionsParser()
+static void initState(struct OptionsParserState *state)
 {
-	struct OptionsParserState *state = malloc(sizeof(struct OptionsParserState));
-
 	state->parser_func = parser_searchToken;
 	state->parser_func_param = 0;
 	state->parsed_data = NULL;
 	state->parsed_data_size = 0;
+	state->strings = NULL;
+	state->strings_size = 0;
+	state->strings_used = 0;
+	state->is_fixed = 0;
 
 	state->options = 0;
+}
+
+// ends parsing and returns the links with their targets in one block
+static int finishOptionsParser(int priority, struct OptionsParserState *state, struct AlternativeLink **links)
+{
+	struct AlternativeLink *parsed_data;
+	char *strings;
+	int errors = 0;
+	int n_links = 0;
 
+	while (state->parser_func != parser_searchToken && (errors = state->parser_func("\n", 1, state)) == 0);
+
+	*links = NULL;
+	if (errors != 0)
+		goto err;
+
+	while (n_links < state->parsed_data_size && state->parsed_data[n_links].type != ALTLINK_EOL)
+		n_links++;
+	if (n_links == 0)
+		goto err;
+
+	parsed_data = state->parsed_data;
+	strings = state->strings;
+	if (!state->is_fixed) {
+		parsed_data = statsMalloc(sizeof(struct AlternativeLink) * (n_links + 1) + state->strings_used);
+		if (parsed_data == NULL) {
+			errors = -1;
+			goto err;
+		}
+		strings = (char*)(parsed_data + n_links + 1);
+		memcpy(parsed_data, state->parsed_data, sizeof(struct AlternativeLink) * (n_links + 1));
+		memcpy(strings, state->strings, state->strings_used);
+		free(state->parsed_data);
+		free(state->strings);
+	}
+
+	for (struct AlternativeLink *ptr = parsed_data; ptr->type != ALTLINK_EOL; ptr++) {
+		ptr->target = strings + ptr->priority;
+		ptr->priority = priority;
+		ptr->options = state->options;
+	}
+	MARK_SINGLE_ALLOCATION(parsed_data + n_links);
+
+	*links = parsed_data;
+	return 0;
+
+err:
+	free(state->parsed_data);
+	if (!state->is_fixed)
+		free(state->strings);
+	return errors;
+}
+
+struct OptionsParserState* initOptionsParser()
+{
+	struct OptionsParserState *state = statsMalloc(sizeof(struct OptionsParserState));
+
+	if (state != NULL)
+		initState(state);
 	return state;
 }
 
@@ -447,21 +564,46 @@ int parseOptionsData(const char *buffer, size_t len, struct OptionsParserState *
 
 struct AlternativeLink* doneOptionsParser(int priority, struct OptionsParserState *state)
 {
-	int errors = 0;
-	while (state->parser_func != parser_searchToken && (errors = state->parser_func("\n", 1, state)) == 0);
+	struct AlternativeLink *links;
 
-	if (errors != 0) {
-		free(state->parsed_data);
-		free(state);
-		return NULL;
-	}
+	finishOptionsParser(priority, state, &links);
+	free(state);
+	return links;
+}
 
-	struct AlternativeLink *parsed_data = state->parsed_data;
-	for (struct AlternativeLink *ptr = parsed_data; ptr && ptr->type != ALTLINK_EOL; ptr++) {
-		ptr->priority = priority;
-		ptr->options = state->options;
+int parseOptionsBuffer(const char *buffer, size_t len, int priority, struct AlternativeLink **links)
+{
+	struct OptionsParserState state;
+	int n_links = 1;
+
+	*links = NULL;
+	if (len == 0)
+		return 0;
+
+	// a link starts on a line or after a comma, and the targets are made
+	// of the input bytes, each ended by a NUL in place of its delimiter
+	for (size_t i=0; i<len; i++) {
+		switch (buffer[i]) {
+			case ',':
+			case '\n':
+			case '\r':
+			case '\0':
+				n_links++;
+				break;
+		}
 	}
 
-	free(state);
-	return parsed_data;
+	initState(&state);
+	state.parsed_data = statsMalloc(sizeof(struct AlternativeLink) * (n_links + 1) + len + 1);
+	if (state.parsed_data == NULL)
+		return -1;
+	state.parsed_data_size = n_links + 1;
+	clearLinks(state.parsed_data, 0, state.parsed_data_size);
+	state.strings = (char*)(state.parsed_data + state.parsed_data_size);
+	state.strings_size = len + 1;
+	state.is_fixed = 1;
+
+	if (parseOptionsData(buffer, len, &state) != 0)
+		state.parser_func = parser_alreadyErrorNoResumePossible;
+	return finishOptionsParser(priority, &state, links);
 }
@@ -36,9 +36,22 @@ struct OptionsParserState* initOptionsParser();
 int parseOptionsData(const char *buffer, size_t len, struct OptionsParserState *state);
 
 // Frees parsing state. returns array of links from the options, end with ALTLINK_EOL type
-// entry. NULL on error.
+// entry. NULL on error. The targets are in the same allocation as the array.
 struct AlternativeLink* doneOptionsParser(int priority, struct OptionsParserState *state);
 
+// parses the whole options in buffer at once, into a single allocation
+// sized for it. Links are returned as by doneOptionsParser(), or NULL
+// when the options have none.
+// return 0 on OK, -1 on fail
+int parseOptionsBuffer(const char *buffer, size_t len, int priority, struct AlternativeLink **links);
+
+// the ALTLINK_EOL entry of links that share one allocation with their
+// targets points just past itself. libalts_free_alternatives_ptr() then
+// frees them with one free(), and frees the targets of other arrays,
+// which end with a NULL target, one by one.
+#define MARK_SINGLE_ALLOCATION(eol) ((eol)->target = (const char*)((eol) + 1))
+#define IS_SINGLE_ALLOCATION(eol) ((eol)->target == (const char*)((eol) + 1))
+
 
 
 /* config_parser.c
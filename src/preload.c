@@ -0,0 +1,400 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* LD_PRELOAD shim that executes the target of a symlink to alts directly,
+ * without the intermediate exec of alts. The shim does not link
+ * libalternatives. It is loaded on the first exec of an alts link or
+ * before the first fork(), so that a forked child does not dlopen(), and
+ * other processes pay one readlink() per exec. vfork() children share the
+ * memory of their parent and leave the exec to alts.
+ */
+
+#define _GNU_SOURCE 1
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libalternatives.h"
+
+#ifdef UNITTESTS
+#define INTERPOSED(name) preload_##name
+#else
+#define INTERPOSED(name) name
+#endif
+
+#define EXPORT_FUNC __attribute__((visibility("default")))
+#define DEFAULT_PATH "/bin:/usr/bin"
+
+extern char **environ;
+
+typedef int (*ResolveFunction)(const char *binary_name, char **target, int *options);
+typedef const char* (*UserConfigPathFunction)();
+
+#ifdef UNITTESTS
+static const UserConfigPathFunction user_config_path = libalts_get_user_config_path;
+#else
+// set before the resolver is published
+static UserConfigPathFunction user_config_path;
+#endif
+
+static ResolveFunction getResolver()
+{
+#ifdef UNITTESTS
+	return libalts_resolve_default_binary;
+#else
+	static ResolveFunction resolver;
+	static int is_loaded;
+
+	ResolveFunction ret = __atomic_load_n(&resolver, __ATOMIC_ACQUIRE);
+	if (ret != NULL || __atomic_load_n(&is_loaded, __ATOMIC_ACQUIRE))
+		return ret;
+
+	// dlopen() returns the same handle if two threads race here
+	void *library = dlopen(LIBALTERNATIVES_SONAME, RTLD_NOW | RTLD_LOCAL);
+	if (library != NULL) {
+		*(void**)&user_config_path = dlsym(library, "libalts_get_user_config_path");
+		if (user_config_path != NULL)
+			*(void**)&ret = dlsym(library, "libalts_resolve_default_binary");
+	}
+
+	__atomic_store_n(&resolver, ret, __ATOMIC_RELEASE);
+	__atomic_store_n(&is_loaded, 1, __ATOMIC_RELEASE);
+	return ret;
+#endif
+}
+
+// pid of the process that may resolve. A vfork() child skips the fork
+// handlers and, sharing our memory, must not resolve, so it finds the pid
+// of its parent here.
+static pid_t resolving_pid;
+
+static void loadResolverBeforeFork()
+{
+	getResolver();
+}
+
+static void updateResolvingPid()
+{
+	resolving_pid = getpid();
+}
+
+__attribute__((constructor))
+static void initPreload()
+{
+	resolving_pid = getpid();
+	pthread_atfork(loadResolverBeforeFork, NULL, updateResolvingPid);
+}
+
+static void getNextFunction(void **function, const char *name)
+{
+	*function = dlsym(RTLD_NEXT, name);
+	if (*function == NULL)
+		abort();
+}
+
+#define NEXT_FUNCTION(type, name) \
+	static type next_##name; \
+	if (next_##name == NULL) \
+		getNextFunction((void**)&next_##name, #name)
+
+typedef int (*ExecveFunction)(const char *, char *const [], char *const []);
+typedef int (*PosixSpawnFunction)(pid_t *, const char *, const posix_spawn_file_actions_t *,
+                                  const posix_spawnattr_t *, char *const [], char *const []);
+
+static int isAltsLink(const char *path)
+{
+	char target[PATH_MAX];
+
+	const ssize_t len = readlink(path, target, sizeof(target) - 1);
+	if (len <= 0)
+		return 0;
+	target[len] = '\0';
+
+	const char *name = strrchr(target, '/');
+	return strcmp(name ? name + 1 : target, "alts") == 0;
+}
+
+static const char* findEnv(char *const envp[], const char *name)
+{
+	const size_t len = strlen(name);
+
+	for (; envp != NULL && *envp != NULL; envp++) {
+		if (strncmp(*envp, name, len) == 0 && (*envp)[len] == '=')
+			return *envp + len + 1;
+	}
+
+	return NULL;
+}
+
+// the user override alts would read with envp, like libalts_get_user_config_path()
+// returns 0 and path, or -1 if there is none
+static int findUserConfigPath(char *const envp[], char *path, size_t size)
+{
+	const char *config_home = findEnv(envp, "XDG_CONFIG_HOME");
+	int len;
+
+	if (config_home != NULL) {
+		len = snprintf(path, size, "%s/" CONFIG_FILENAME, config_home);
+	}
+	else {
+		config_home = findEnv(envp, "HOME");
+		if (config_home == NULL)
+			return -1;
+		len = snprintf(path, size, "%s/.config/" CONFIG_FILENAME, config_home);
+	}
+
+	return (size_t)len < size ? 0 : -1;
+}
+
+// resolution runs here with our configuration, so alts must see the same
+static int isResolvableEnv(char *const envp[])
+{
+	char path[PATH_MAX];
+
+	// alts would export its resolution to the inherited cache
+	if (findEnv(envp, "LIBALTERNATIVES_CACHE") != NULL)
+		return 0;
+
+	// the library keeps the override path of our environment when it was
+	// first asked, so a later setenv() of HOME is compared as well
+	const char *own_path = user_config_path();
+	if (findUserConfigPath(envp, path, sizeof(path)) < 0) {
+		if (own_path != NULL)
+			return 0;
+	}
+	else if (own_path == NULL || strcmp(path, own_path) != 0) {
+		return 0;
+	}
+
+	if (envp != environ) {
+		const char *value = findEnv(envp, "LIBALTERNATIVES_DEBUG");
+		const char *own_value = getenv("LIBALTERNATIVES_DEBUG");
+
+		if ((value == NULL) != (own_value == NULL))
+			return 0;
+		if (value != NULL && strcmp(value, own_value) != 0)
+			return 0;
+	}
+
+	return 1;
+}
+
+// returns 0 and what alts would execute for path, or -1 to leave the exec alone
+static int resolveAltsLink(const char *path, char *const argv[], char *const envp[], char **target, char ***target_argv)
+{
+	ResolveFunction resolve;
+	int options;
+	size_t argc;
+
+	if (argv == NULL || argv[0] == NULL || getpid() != resolving_pid || !isAltsLink(path))
+		return -1;
+
+	// alts resolves by the name it is executed as
+	const char *binary_name = strrchr(argv[0], '/');
+	binary_name = (binary_name ? binary_name + 1 : argv[0]);
+	if (binary_name[0] == '\0' || strcmp(binary_name, "alts") == 0)
+		return -1;
+
+	if ((resolve = getResolver()) == NULL || !isResolvableEnv(envp))
+		return -1;
+
+	const int saved_error = errno;
+	if (resolve(binary_name, target, &options) != 0) {
+		errno = saved_error;
+		return -1;
+	}
+
+	for (argc = 0; argv[argc] != NULL; argc++)
+		;
+	*target_argv = malloc(sizeof(char*) * (argc + 1));
+	if (*target_argv == NULL) {
+		free(*target);
+		errno = saved_error;
+		return -1;
+	}
+
+	memcpy(*target_argv, argv, sizeof(char*) * (argc + 1));
+	(*target_argv)[0] = (options & ALTLINK_OPTIONS_KEEPARGV0) ? (char*)binary_name : *target;
+	return 0;
+}
+
+// first executable match for file in PATH, like execvp() would find it
+static int findInPath(const char *file, char *path, size_t size)
+{
+	const char *search_path = getenv("PATH");
+	if (search_path == NULL)
+		search_path = DEFAULT_PATH;
+
+	while (1) {
+		const char *end = strchrnul(search_path, ':');
+		const int len = (int)(end - search_path);
+
+		// an empty entry is the current directory
+		if ((size_t)snprintf(path, size, "%.*s%s%s", len, search_path, len ? "/" : "", file) < size &&
+		    access(path, X_OK) == 0)
+			return 0;
+
+		if (*end == '\0')
+			return -1;
+		search_path = end + 1;
+	}
+}
+
+EXPORT_FUNC
+int INTERPOSED(execve)(const char *path, char *const argv[], char *const envp[])
+{
+	NEXT_FUNCTION(ExecveFunction, execve);
+	char *target, **target_argv;
+
+	if (resolveAltsLink(path, argv, envp, &target, &target_argv) == 0) {
+		next_execve(target, target_argv, envp);
+
+		// let alts report the failure
+		free(target_argv);
+		free(target);
+	}
+
+	return next_execve(path, argv, envp);
+}
+
+EXPORT_FUNC
+int INTERPOSED(execv)(const char *path, char *const argv[])
+{
+	return INTERPOSED(execve)(path, argv, environ);
+}
+
+EXPORT_FUNC
+int INTERPOSED(execvpe)(const char *file, char *const argv[], char *const envp[])
+{
+	NEXT_FUNCTION(ExecveFunction, execvpe);
+	char path[PATH_MAX];
+
+	if (strchr(file, '/') != NULL)
+		return INTERPOSED(execve)(file, argv, envp);
+
+	if (file[0] != '\0' && findInPath(file, path, sizeof(path)) == 0 && isAltsLink(path))
+		return INTERPOSED(execve)(path, argv, envp);
+
+	return next_execvpe(file, argv, envp);
+}
+
+EXPORT_FUNC
+int INTERPOSED(execvp)(const char *file, char *const argv[])
+{
+	return INTERPOSED(execvpe)(file, argv, environ);
+}
+
+// copies the variadic arguments after arg into argv, which holds argc + 1
+#define COLLECT_ARGS(arg, argc, argv) do { \
+	va_list args; \
+	va_start(args, arg); \
+	argv[0] = (char*)arg; \
+	for (size_t i = 1; i <= argc; i++) \
+		argv[i] = va_arg(args, char*); \
+	va_end(args); \
+} while (0)
+
+// arg, the first argument, is never NULL
+static size_t countArgs(va_list args)
+{
+	size_t argc = 1;
+
+	while (va_arg(args, char*) != NULL)
+		argc++;
+	return argc;
+}
+
+EXPORT_FUNC
+int INTERPOSED(execl)(const char *path, const char *arg, ...)
+{
+	va_list args;
+	va_start(args, arg);
+	const size_t argc = countArgs(args);
+	va_end(args);
+
+	char *argv[argc + 1];
+	COLLECT_ARGS(arg, argc, argv);
+	return INTERPOSED(execve)(path, argv, environ);
+}
+
+EXPORT_FUNC
+int INTERPOSED(execlp)(const char *file, const char *arg, ...)
+{
+	va_list args;
+	va_start(args, arg);
+	const size_t argc = countArgs(args);
+	va_end(args);
+
+	char *argv[argc + 1];
+	COLLECT_ARGS(arg, argc, argv);
+	return INTERPOSED(execvpe)(file, argv, environ);
+}
+
+EXPORT_FUNC
+int INTERPOSED(execle)(const char *path, const char *arg, ...)
+{
+	va_list args;
+	va_start(args, arg);
+	const size_t argc = countArgs(args);
+	va_end(args);
+
+	// envp follows the terminating NULL
+	char *argv[argc + 2];
+	COLLECT_ARGS(arg, argc + 1, argv);
+	return INTERPOSED(execve)(path, argv, (char**)argv[argc + 1]);
+}
+
+EXPORT_FUNC
+int INTERPOSED(posix_spawn)(pid_t *pid, const char *path, const posix_spawn_file_actions_t *file_actions,
+                            const posix_spawnattr_t *attrp, char *const argv[], char *const envp[])
+{
+	NEXT_FUNCTION(PosixSpawnFunction, posix_spawn);
+	char *target, **target_argv;
+
+	if (resolveAltsLink(path, argv, envp, &target, &target_argv) == 0) {
+		const int ret = next_posix_spawn(pid, target, file_actions, attrp, target_argv, envp);
+		free(target_argv);
+		free(target);
+		if (ret == 0)
+			return 0;
+	}
+
+	return next_posix_spawn(pid, path, file_actions, attrp, argv, envp);
+}
+
+EXPORT_FUNC
+int INTERPOSED(posix_spawnp)(pid_t *pid, const char *file, const posix_spawn_file_actions_t *file_actions,
+                             const posix_spawnattr_t *attrp, char *const argv[], char *const envp[])
+{
+	NEXT_FUNCTION(PosixSpawnFunction, posix_spawnp);
+	char path[PATH_MAX];
+
+	if (strchr(file, '/') != NULL)
+		return INTERPOSED(posix_spawn)(pid, file, file_actions, attrp, argv, envp);
+
+	if (file[0] != '\0' && findInPath(file, path, sizeof(path)) == 0 && isAltsLink(path))
+		return INTERPOSED(posix_spawn)(pid, path, file_actions, attrp, argv, envp);
+
+	return next_posix_spawnp(pid, file, file_actions, attrp, argv, envp);
+}
@@ -0,0 +1,38 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* USDT probes of the libalternatives provider, eg.
+ *
+ *   bpftrace -e 'usdt:/usr/lib64/libalternatives.so.1:libalternatives:exec
+ *                { printf("%s %s\n", str(arg0), str(arg1)); }'
+ *
+ * A probe is a single nop until a tracer attaches to it. Without
+ * sys/sdt.h at build time they are left out.
+ */
+
+#pragma once
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define PROBE1(name, a) DTRACE_PROBE1(libalternatives, name, a)
+#define PROBE2(name, a, b) DTRACE_PROBE2(libalternatives, name, a, b)
+#define PROBE3(name, a, b, c) DTRACE_PROBE3(libalternatives, name, a, b, c)
+#else
+#define PROBE1(name, a) do {} while (0)
+#define PROBE2(name, a, b) do {} while (0)
+#define PROBE3(name, a, b, c) do {} while (0)
+#endif
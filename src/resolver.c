@@ -0,0 +1,158 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE 1
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libalternatives.h"
+#include "internal.h"
+#include "parser.h"
+#include "stats.h"
+
+#ifdef UNITTESTS
+// tests never talk to a system wide daemon
+static const char *resolver_socket_path = NULL;
+
+void setResolverSocketPath(const char *path)
+{
+	resolver_socket_path = path;
+}
+#else
+static const char *resolver_socket_path = ALTSD_SOCKET_PATH;
+#endif
+
+static int connectResolver()
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	struct ucred peer;
+	socklen_t peer_len = sizeof(peer);
+
+	if (resolver_socket_path == NULL || strlen(resolver_socket_path) >= sizeof(addr.sun_path))
+		return -1;
+	strcpy(addr.sun_path, resolver_socket_path);
+
+	// non-blocking, so a daemon with a full backlog is not waited for
+	const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (fd < 0)
+		return -1;
+
+	if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+		goto err;
+
+	// only trust answers of root or of ourselves
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &peer_len) < 0 ||
+	    (peer.uid != 0 && peer.uid != geteuid()))
+		goto err;
+
+	return fd;
+
+err:
+	close(fd);
+	return -1;
+}
+
+static int decodeReply(const char *reply, size_t size, struct AlternativeLink **alternatives)
+{
+	struct ResolverReplyHeader header;
+	struct AlternativeLink *alts;
+	size_t pos = sizeof(header);
+	char *strings;
+
+	if (size < sizeof(header))
+		return -1;
+	memcpy(&header, reply, sizeof(header));
+	if (header.status != 0 || header.n_links == 0 || header.n_links > size / sizeof(struct ResolverLink))
+		return -1;
+
+	// targets follow the links in the same allocation, as parsed, and
+	// are no longer than the reply
+	alts = statsCalloc(1, sizeof(struct AlternativeLink) * (header.n_links + 1) + size);
+	if (alts == NULL)
+		return -1;
+	alts[0].type = ALTLINK_EOL;
+	strings = (char*)(alts + header.n_links + 1);
+
+	for (unsigned i=0; i<header.n_links; i++) {
+		struct ResolverLink link;
+
+		if (size - pos < sizeof(link))
+			goto err;
+		memcpy(&link, reply + pos, sizeof(link));
+		pos += sizeof(link);
+
+		if (link.target_size == 0 || size - pos < link.target_size || reply[pos + link.target_size - 1] != '\0')
+			goto err;
+
+		alts[i].priority = link.priority;
+		alts[i].type = link.type;
+		alts[i].options = link.options;
+		alts[i].target = memcpy(strings, reply + pos, link.target_size);
+		alts[i+1].type = ALTLINK_EOL;
+		strings += link.target_size;
+		pos += link.target_size;
+	}
+
+	MARK_SINGLE_ALLOCATION(alts + header.n_links);
+	*alternatives = alts;
+	return 0;
+
+err:
+	free(alts);
+	return -1;
+}
+
+int queryResolver(const char *binary_name, int user_priority, struct AlternativeLink **alternatives)
+{
+	struct ResolverRequest request = { .user_priority = user_priority };
+	struct pollfd pfd = { .events = POLLIN };
+	char reply[RESOLVER_MAX_MESSAGE];
+	ssize_t reply_size;
+	int ret = -1;
+
+	if (strlen(binary_name) >= sizeof(request.binary_name))
+		return -1;
+	strcpy(request.binary_name, binary_name);
+
+	const int saved_error = errno;
+	pfd.fd = connectResolver();
+	if (pfd.fd < 0)
+		goto err;
+
+	if (send(pfd.fd, &request, sizeof(request), MSG_NOSIGNAL) != sizeof(request))
+		goto err;
+
+	if (poll(&pfd, 1, RESOLVER_TIMEOUT_MS) != 1 || (pfd.revents & POLLIN) == 0)
+		goto err;
+
+	reply_size = recv(pfd.fd, reply, sizeof(reply), 0);
+	if (reply_size > 0)
+		ret = decodeReply(reply, reply_size, alternatives);
+
+err:
+	if (pfd.fd >= 0)
+		close(pfd.fd);
+	errno = saved_error;
+	return ret;
+}
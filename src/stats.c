@@ -0,0 +1,106 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE 1
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+#include "internal.h"
+
+struct LibaltsStats libalternatives_stats;
+int libalternatives_stats_enabled = 0;
+
+#ifdef UNITTESTS
+void setStatsEnabled(int enabled)
+{
+	libalternatives_stats_enabled = enabled ? 2 : 1;
+}
+#endif
+
+int isStatsEnabled()
+{
+	return isEnvSwitchEnabled(&libalternatives_stats_enabled, STATS_ENV, 0);
+}
+
+int startStatsCall(struct timespec *start)
+{
+	clock_gettime(CLOCK_MONOTONIC, start);
+	return 1;
+}
+
+void endStatsCall(enum LibaltsStatsFunction function, const struct timespec *start)
+{
+	struct LibaltsFunctionStats *stats = &libalternatives_stats.functions[function];
+	struct timespec now;
+	int bucket = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	const unsigned long long ns = (now.tv_sec - start->tv_sec) * 1000000000ULL + (now.tv_nsec - start->tv_nsec);
+
+	for (unsigned long long us = ns / 1000; us > 0 && bucket < LIBALTS_STATS_LATENCY_BUCKETS - 1; us >>= 1)
+		bucket++;
+
+	__atomic_fetch_add(&stats->calls, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&stats->total_ns, ns, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&stats->latency[bucket], 1, __ATOMIC_RELAXED);
+}
+
+#ifndef LIBALTS_EXEC_ONLY
+void* statsMalloc(size_t size)
+{
+	STATS_ADD(allocations, 1);
+	return malloc(size);
+}
+
+void* statsCalloc(size_t n, size_t size)
+{
+	STATS_ADD(allocations, 1);
+	return calloc(n, size);
+}
+
+void* statsRealloc(void *ptr, size_t size)
+{
+	STATS_ADD(allocations, 1);
+	return realloc(ptr, size);
+}
+
+char* statsStrdup(const char *s)
+{
+	STATS_ADD(allocations, 1);
+	return strdup(s);
+}
+
+char* statsStrndup(const char *s, size_t n)
+{
+	STATS_ADD(allocations, 1);
+	return strndup(s, n);
+}
+
+int statsAsprintf(char **str, const char *format, ...)
+{
+	va_list args;
+
+	STATS_ADD(allocations, 1);
+	va_start(args, format);
+	const int ret = vasprintf(str, format, args);
+	va_end(args);
+	return ret;
+}
+#endif
@@ -0,0 +1,77 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* stats.c
+ * Cumulative statistics of libalts_get_stats(), kept while
+ * LIBALTERNATIVES_STATS=1 is in the environment. Counters are only
+ * updated with relaxed atomic additions, so threads never wait on each
+ * other. Disabled, each probe checks a flag. The exec only library keeps
+ * none.
+ *
+ * Allocations are counted by calling the wrappers below in place of the
+ * allocation functions.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <time.h>
+
+#include "libalternatives.h"
+
+#define STATS_ENV "LIBALTERNATIVES_STATS"
+
+extern struct LibaltsStats libalternatives_stats;
+
+// environment switch, see isEnvSwitchEnabled()
+extern int libalternatives_stats_enabled;
+
+int isStatsEnabled();
+int startStatsCall(struct timespec *start);
+void endStatsCall(enum LibaltsStatsFunction function, const struct timespec *start);
+
+#ifdef LIBALTS_EXEC_ONLY
+#define STATS_ADD(counter, n) ((void)0)
+#define STATS_BEGIN() ((void)0)
+#define STATS_END(function) ((void)0)
+
+#define statsMalloc(size) malloc(size)
+#define statsCalloc(n, size) calloc(n, size)
+#define statsRealloc(ptr, size) realloc(ptr, size)
+#define statsStrdup(s) strdup(s)
+#define statsStrndup(s, n) strndup(s, n)
+#define statsAsprintf(...) asprintf(__VA_ARGS__)
+#else
+#define IS_STATS_ENABLED() \
+	(__builtin_expect(libalternatives_stats_enabled, 1) == 1 ? 0 : isStatsEnabled())
+#define STATS_ADD(counter, n) do { \
+	if (IS_STATS_ENABLED()) \
+		__atomic_fetch_add(&libalternatives_stats.counter, (n), __ATOMIC_RELAXED); \
+} while (0)
+#define STATS_BEGIN() \
+	struct timespec stats_start; \
+	const int stats_call = IS_STATS_ENABLED() ? startStatsCall(&stats_start) : 0
+#define STATS_END(function) do { \
+	if (stats_call) \
+		endStatsCall(function, &stats_start); \
+} while (0)
+
+void* statsMalloc(size_t size);
+void* statsCalloc(size_t n, size_t size);
+void* statsRealloc(void *ptr, size_t size);
+char* statsStrdup(const char *s);
+char* statsStrndup(const char *s, size_t n);
+int statsAsprintf(char **str, const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+#endif
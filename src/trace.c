@@ -0,0 +1,121 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE 1
+
+#include <fcntl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "internal.h"
+
+#define TRACE_ENV "LIBALTERNATIVES_TRACE"
+#define TRACE_FILE_ENV "LIBALTERNATIVES_TRACE_FILE"
+
+int libalternatives_trace = 0;
+
+static struct
+{
+	const char *binary_name;
+	struct timespec start;
+	struct timespec phase_start[TRACE_PHASE_COUNT];
+	long long phase_ns[TRACE_PHASE_COUNT];
+} trace;
+
+static const char *const phase_names[TRACE_PHASE_COUNT] = {
+	"user_config_ns",
+	"system_config_ns",
+	"dir_scan_ns",
+	"options_parse_ns",
+	"pre_exec_ns",
+};
+
+static long long elapsedNanoseconds(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1000000000LL + (end->tv_nsec - start->tv_nsec);
+}
+
+void startTrace(const char *binary_name)
+{
+	const char *rate = secure_getenv(TRACE_ENV);
+	libalternatives_trace = 0;
+	if (rate == NULL)
+		return;
+
+	const long sample_rate = atol(rate);
+	if (sample_rate <= 0)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &trace.start);
+
+	// the clock is random enough to sample independent executions
+	if (sample_rate > 1 && (trace.start.tv_nsec / 1000) % sample_rate != 0)
+		return;
+
+	for (int i = 0; i < TRACE_PHASE_COUNT; i++)
+		trace.phase_ns[i] = 0;
+	trace.binary_name = binary_name;
+	libalternatives_trace = 1;
+}
+
+void beginTracePhase(enum TracePhase phase)
+{
+	clock_gettime(CLOCK_MONOTONIC, &trace.phase_start[phase]);
+}
+
+void endTracePhase(enum TracePhase phase)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	trace.phase_ns[phase] += elapsedNanoseconds(&trace.phase_start[phase], &now);
+}
+
+void emitTrace(const char *target, const char *source)
+{
+	char line[PATH_MAX + 512];
+	struct timespec now;
+	int len, fd = STDERR_FILENO;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	libalternatives_trace = 0;
+
+	len = snprintf(line, sizeof(line), "libalternatives-trace binary=\"%s\" pid=%d source=%s",
+	               trace.binary_name, (int)getpid(), source);
+	for (int i = 0; i < TRACE_PHASE_COUNT && len < (int)sizeof(line); i++)
+		len += snprintf(line + len, sizeof(line) - len, " %s=%lld", phase_names[i], trace.phase_ns[i]);
+	if (len < (int)sizeof(line))
+		len += snprintf(line + len, sizeof(line) - len, " total_ns=%lld target=\"%s\"\n",
+		                elapsedNanoseconds(&trace.start, &now), target ? target : "");
+	if (len >= (int)sizeof(line))
+		return;
+
+	const char *path = secure_getenv(TRACE_FILE_ENV);
+	if (path != NULL)
+		fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+
+	if (fd < 0)
+		return;
+
+	// a single write, so lines of concurrent processes are not mixed
+	const ssize_t written = write(fd, line, len);
+	(void)written;
+
+	if (fd != STDERR_FILENO)
+		close(fd);
+}
@@ -0,0 +1,275 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE 1
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libalternatives.h"
+#include "internal.h"
+#include "stats.h"
+
+#define USAGE_FILE_SIZE (sizeof(struct UsageHeader) + USAGE_SLOTS * sizeof(struct UsageSlot))
+
+// FNV-1a of the name and the priority, never 0
+static uint64_t usageKey(const char *binary_name, int priority)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (const unsigned char *p = (const unsigned char*)binary_name; *p; p++)
+		hash = (hash ^ *p) * 1099511628211ULL;
+	for (size_t i = 0; i < sizeof(priority); i++)
+		hash = (hash ^ ((unsigned)priority >> (8 * i) & 0xff)) * 1099511628211ULL;
+
+	return hash != 0 ? hash : 1;
+}
+
+static int isValidUsageHeader(const struct UsageHeader *header)
+{
+	return memcmp(header->magic, USAGE_MAGIC, sizeof(header->magic)) == 0 &&
+	       header->n_slots == USAGE_SLOTS &&
+	       header->slot_size == sizeof(struct UsageSlot);
+}
+
+// environment switch, see isEnvSwitchEnabled()
+static int is_usage_enabled;
+
+#ifdef UNITTESTS
+void setUsageEnabled(int enabled)
+{
+	is_usage_enabled = enabled ? 2 : 1;
+}
+#endif
+
+// open file description locks, so that threads of a process exclude
+// each other too. Released when the file is closed. len 0 is the
+// whole file.
+static int lockUsage(int fd, short type, int cmd, off_t start, off_t len)
+{
+	struct flock lock = { .l_type = type, .l_whence = SEEK_SET, .l_start = start, .l_len = len };
+
+	while (fcntl(fd, cmd, &lock) < 0) {
+		if (errno != EINTR)
+			return -1;
+	}
+	return 0;
+}
+
+// opens the usage file if it has the expected size and header, or fails
+// with EINVAL. The file is only accessed with pread() and pwrite(), so that
+// a file truncated by another process cannot fault the caller.
+static int openUsage(const char *path, int flags)
+{
+	struct UsageHeader header;
+	struct stat st;
+
+	const int fd = open(path, flags | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size != USAGE_FILE_SIZE ||
+	    pread(fd, &header, sizeof(header), 0) != sizeof(header) || !isValidUsageHeader(&header)) {
+		close(fd);
+		errno = EINVAL;
+		return -1;
+	}
+
+	return fd;
+}
+
+static off_t slotOffset(unsigned slot)
+{
+	return sizeof(struct UsageHeader) + (off_t)slot * sizeof(struct UsageSlot);
+}
+
+void countUsage(const char *path, const char *binary_name, int priority)
+{
+	const int saved_error = errno;
+	int fd = -1;
+
+	if (!isEnvSwitchEnabled(&is_usage_enabled, USAGE_ENV, 0))
+		return;
+
+	fd = openUsage(path, O_RDWR);
+	if (fd < 0)
+		goto end;
+
+	// only the probed slot is locked, and a count never waits for it, so
+	// that a stopped process holding a lock cannot delay executions. A
+	// contended count is dropped.
+	const uint64_t key = usageKey(binary_name, priority);
+	for (unsigned i = 0; i < USAGE_MAX_PROBES; i++) {
+		const off_t offset = slotOffset((key + i) % USAGE_SLOTS);
+		struct UsageSlot slot;
+
+		if (lockUsage(fd, F_WRLCK, F_OFD_SETLK, offset, sizeof(slot)) < 0 ||
+		    pread(fd, &slot, sizeof(slot), offset) != sizeof(slot))
+			break;
+
+		if (slot.key == 0) {
+			memset(&slot, 0, sizeof(slot));
+			slot.key = key;
+			slot.count = 1;
+			slot.priority = priority;
+			snprintf(slot.binary_name, sizeof(slot.binary_name), "%s", binary_name);
+			pwrite(fd, &slot, sizeof(slot), offset);
+			break;
+		}
+		if (slot.key == key) {
+			slot.count++;
+			pwrite(fd, &slot.count, sizeof(slot.count), offset + offsetof(struct UsageSlot, count));
+			break;
+		}
+		lockUsage(fd, F_UNLCK, F_OFD_SETLK, offset, sizeof(slot));
+	}
+
+end:
+	if (fd >= 0)
+		close(fd);
+	errno = saved_error;
+}
+
+static int compareUsage(const void *a, const void *b)
+{
+	const struct LibaltsUsage *x = a, *y = b;
+
+	if (x->count != y->count)
+		return x->count < y->count ? 1 : -1;
+
+	const int ret = strcmp(x->binary_name, y->binary_name);
+	return ret != 0 ? ret : (x->priority > y->priority) - (x->priority < y->priority);
+}
+
+int loadUsage(const char *path, struct LibaltsUsage **usage, size_t *size)
+{
+	struct UsageSlot *slots = NULL;
+	const size_t slots_size = USAGE_SLOTS * sizeof(struct UsageSlot);
+	int ret = -1;
+	size_t n = 0;
+
+	*usage = NULL;
+	*size = 0;
+
+	const int fd = openUsage(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	slots = statsMalloc(slots_size);
+	if (slots == NULL || lockUsage(fd, F_RDLCK, F_OFD_SETLKW, 0, 0) < 0)
+		goto err;
+	if (pread(fd, slots, slots_size, slotOffset(0)) != (ssize_t)slots_size) {
+		errno = EINVAL;
+		goto err;
+	}
+
+	for (unsigned i = 0; i < USAGE_SLOTS; i++) {
+		if (slots[i].count > 0)
+			n++;
+	}
+
+	// names are copied behind the entries, so a single free() releases all
+	const size_t name_size = sizeof(slots->binary_name);
+	struct LibaltsUsage *entries = statsMalloc((n > 0 ? n : 1) * (sizeof(struct LibaltsUsage) + name_size));
+	if (entries == NULL)
+		goto err;
+
+	char *names = (char*)(entries + n);
+	size_t pos = 0;
+	for (unsigned i = 0; i < USAGE_SLOTS && pos < n; i++) {
+		if (slots[i].count == 0)
+			continue;
+
+		char *name = names + pos * name_size;
+		memcpy(name, slots[i].binary_name, name_size);
+		name[name_size - 1] = '\0';
+
+		entries[pos].binary_name = name;
+		entries[pos].priority = slots[i].priority;
+		entries[pos].count = slots[i].count;
+		pos++;
+	}
+
+	qsort(entries, pos, sizeof(struct LibaltsUsage), compareUsage);
+	*usage = entries;
+	*size = pos;
+	ret = 0;
+
+err:
+	{
+		const int saved_error = errno;
+		free(slots);
+		close(fd);
+		errno = saved_error;
+	}
+	return ret;
+}
+
+int resetUsage(const char *path)
+{
+	struct UsageHeader header = { .n_slots = USAGE_SLOTS, .slot_size = sizeof(struct UsageSlot) };
+	struct stat st;
+	mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+	char *temp_path = NULL;
+	int fd = -1, ret = -1, is_temp_created = 0;
+
+	memcpy(header.magic, USAGE_MAGIC, sizeof(header.magic));
+
+	// keeps permissions that an administrator widened
+	if (stat(path, &st) == 0)
+		mode = st.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO);
+
+	if (statsAsprintf(&temp_path, "%s.XXXXXX", path) < 0) {
+		temp_path = NULL;
+		goto err;
+	}
+
+	fd = mkostemp(temp_path, O_CLOEXEC);
+	if (fd < 0)
+		goto err;
+	is_temp_created = 1;
+
+	if (fchmod(fd, mode) < 0 || ftruncate(fd, USAGE_FILE_SIZE) < 0)
+		goto err;
+	if (write(fd, &header, sizeof(header)) != sizeof(header))
+		goto err;
+
+	ret = close(fd);
+	fd = -1;
+	if (ret < 0)
+		goto err;
+	ret = rename(temp_path, path);
+
+err:
+	if (ret != 0) {
+		const int saved_error = errno;
+		if (fd >= 0)
+			close(fd);
+		if (is_temp_created)
+			unlink(temp_path);
+		errno = saved_error;
+	}
+	free(temp_path);
+	return ret;
+}
@@ -0,0 +1,92 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <malloc.h>
+#include <stddef.h>
+
+#include "alloc_counter.h"
+
+// glibc calls replacements of these also for its own allocations, and
+// exports the originals under these names
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+// the replacements must be visible to libc, the build hides symbols
+#define REPLACEMENT __attribute__((visibility("default")))
+
+// heap use counts usable sizes, which include the rounding of malloc
+static unsigned long allocations;
+static long live_bytes, peak_bytes, start_bytes;
+
+static void countAllocation(void *ptr)
+{
+	allocations++;
+	live_bytes += malloc_usable_size(ptr);
+	if (live_bytes > peak_bytes)
+		peak_bytes = live_bytes;
+}
+
+REPLACEMENT void* malloc(size_t size)
+{
+	void *ptr = __libc_malloc(size);
+	if (ptr != NULL)
+		countAllocation(ptr);
+	return ptr;
+}
+
+REPLACEMENT void* calloc(size_t n, size_t size)
+{
+	void *ptr = __libc_calloc(n, size);
+	if (ptr != NULL)
+		countAllocation(ptr);
+	return ptr;
+}
+
+REPLACEMENT void* realloc(void *ptr, size_t size)
+{
+	const size_t old_size = malloc_usable_size(ptr);
+	void *new_ptr = __libc_realloc(ptr, size);
+
+	// realloc(ptr, 0) frees ptr and returns NULL
+	if (new_ptr != NULL || size == 0)
+		live_bytes -= old_size;
+	if (new_ptr != NULL)
+		countAllocation(new_ptr);
+	return new_ptr;
+}
+
+REPLACEMENT void free(void *ptr)
+{
+	live_bytes -= malloc_usable_size(ptr);
+	__libc_free(ptr);
+}
+
+void startAllocCount()
+{
+	allocations = 0;
+	start_bytes = live_bytes;
+	peak_bytes = live_bytes;
+}
+
+void stopAllocCount(struct AllocCount *count)
+{
+	count->allocations = allocations;
+	count->peak_bytes = peak_bytes - start_bytes;
+	count->leaked_bytes = live_bytes - start_bytes;
+}
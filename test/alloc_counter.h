@@ -0,0 +1,33 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+/* Linking alloc_counter.c replaces malloc(), calloc(), realloc() and
+ * free() of the whole program, including the allocations that libc makes
+ * for the library, like in fopen() or strdup(). Counting is not thread
+ * safe, so only single threaded programs should use it.
+ */
+
+struct AllocCount
+{
+	unsigned long allocations; // malloc, calloc and realloc calls
+	long peak_bytes; // highest heap use above the start
+	long leaked_bytes; // heap use at the end above the start
+};
+
+void startAllocCount();
+void stopAllocCount(struct AllocCount *count);
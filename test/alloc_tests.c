@@ -0,0 +1,209 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <CUnit/CUnit.h>
+
+#include "../src/libalternatives.h"
+#include "alloc_counter.h"
+
+extern void setConfigPath(const char *config_path);
+
+/* Allocation budgets of the public functions on test/test_defaults.
+ *
+ * Each call is counted with the allocator replaced by alloc_counter.c,
+ * including what libc allocates for it and freeing the result. The
+ * budgets are what the calls need today, so a change that allocates more
+ * fails here and has to raise the budget on purpose. Peak heap budgets
+ * are rounded up to 256 bytes, since they depend on the rounding of
+ * malloc. bench/alts-bench reports the same on larger synthetic trees.
+ */
+
+// with the daemon, the user override is also read to send it along
+#ifdef USE_ALTSD
+#define ALTSD_ALLOCATIONS 18
+#else
+#define ALTSD_ALLOCATIONS 0
+#endif
+
+struct AllocBudget
+{
+	const char *name;
+	void (*call)();
+	unsigned long allocations;
+	long peak_bytes;
+};
+
+static char user_config_path[] = "/tmp/libalternatives_allocs_XXXXXX";
+
+static void loadHighest()
+{
+	struct AlternativeLink *alts;
+	libalts_load_highest_priority_binary_alternatives("multiple_alts", &alts);
+	libalts_free_alternatives_ptr(&alts);
+}
+
+static void loadExact()
+{
+	struct AlternativeLink *alts;
+	libalts_load_exact_priority_binary_alternatives("multiple_alts", 20, &alts);
+	libalts_free_alternatives_ptr(&alts);
+}
+
+static void loadAvailableBinaries()
+{
+	char **binaries;
+	size_t size;
+
+	if (libalts_load_available_binaries(&binaries, &size) != 0)
+		return;
+	for (size_t i=0; i<size; i++)
+		free(binaries[i]);
+	free(binaries);
+}
+
+static void loadBinaryPriorities()
+{
+	int *priorities;
+	size_t size;
+
+	if (libalts_load_binary_priorities("multiple_alts", &priorities, &size) == 0)
+		free(priorities);
+}
+
+static void readPriorityFromFile()
+{
+	libalts_read_binary_configured_priority_from_file("multiple_alts", user_config_path);
+}
+
+static void writePriorityToFile()
+{
+	libalts_write_binary_configured_priority_to_file("multiple_alts", 20, user_config_path);
+}
+
+static void readConfiguredPriority()
+{
+	int src;
+	libalts_read_configured_priority("multiple_alts", &src);
+}
+
+static void resolveDefaultBinary()
+{
+	char *target;
+	int options;
+
+	if (libalts_resolve_default_binary("multiple_alts", &target, &options) == 0)
+		free(target);
+}
+
+static void getDefaultManpages()
+{
+	char **manpages = libalts_get_default_manpages("multiple_alts");
+
+	for (char **p = manpages; p != NULL && *p != NULL; p++)
+		free(*p);
+	free(manpages);
+}
+
+static const struct AllocBudget budgets[] = {
+	{"load_highest_priority_binary_alternatives", loadHighest, 4, 256},
+	{"load_exact_priority_binary_alternatives", loadExact, 1, 256},
+	{"load_available_binaries", loadAvailableBinaries, 6, 256},
+	{"load_binary_priorities", loadBinaryPriorities, 4, 256},
+	{"read_binary_configured_priority_from_file", readPriorityFromFile, 18, 512},
+	{"write_binary_configured_priority_to_file", writePriorityToFile, 59, 768},
+	{"read_configured_priority", readConfiguredPriority, 18, 512},
+	{"resolve_default_binary", resolveDefaultBinary, 20 + ALTSD_ALLOCATIONS, 512},
+	{"get_default_manpages", getDefaultManpages, 21 + ALTSD_ALLOCATIONS, 512},
+};
+
+static int setupAllocTests()
+{
+	const int fd = mkstemp(user_config_path);
+	if (fd < 0)
+		return -1;
+	close(fd);
+
+	// overrides of other binaries around the one that is looked up
+	for (int i=0; i<8; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "unrelated%d", i);
+		if (libalts_write_binary_configured_priority_to_file(name, 10, user_config_path) < 0)
+			return -1;
+		if (i == 4 && libalts_write_binary_configured_priority_to_file("multiple_alts", 20, user_config_path) < 0)
+			return -1;
+	}
+	setConfigPath(user_config_path);
+	return 0;
+}
+
+static int cleanupAllocTests()
+{
+	setConfigPath(NULL);
+	return unlink(user_config_path);
+}
+
+static void callsStayInAllocationBudgets()
+{
+	for (size_t i=0; i<sizeof(budgets)/sizeof(*budgets); i++) {
+		const struct AllocBudget *budget = budgets + i;
+		struct AllocCount count;
+
+		// the first call may fill caches of the library and of libc
+		budget->call();
+		startAllocCount();
+		budget->call();
+		stopAllocCount(&count);
+
+		if (count.allocations > budget->allocations || count.peak_bytes > budget->peak_bytes || count.leaked_bytes != 0)
+			printf("\n  %s: %lu allocations, %ld bytes peak, %ld bytes leaked",
+			       budget->name, count.allocations, count.peak_bytes, count.leaked_bytes);
+		CU_ASSERT(count.allocations <= budget->allocations);
+		CU_ASSERT(count.peak_bytes <= budget->peak_bytes);
+		CU_ASSERT_EQUAL(count.leaked_bytes, 0);
+	}
+}
+
+// links built by a caller own their targets one by one
+static void callerBuiltLinksAreFreed()
+{
+	struct AllocCount count;
+
+	startAllocCount();
+	struct AlternativeLink *alts = calloc(3, sizeof(struct AlternativeLink));
+	CU_ASSERT_PTR_NOT_NULL_FATAL(alts);
+	alts[0].type = ALTLINK_BINARY;
+	alts[0].target = strdup("/usr/bin/vi");
+	alts[1].type = ALTLINK_MANPAGE;
+	alts[1].target = strdup("vi.1");
+	alts[2].type = ALTLINK_EOL;
+	libalts_free_alternatives_ptr(&alts);
+	stopAllocCount(&count);
+
+	CU_ASSERT_PTR_NULL(alts);
+	CU_ASSERT_EQUAL(count.leaked_bytes, 0);
+}
+
+void addAllocTests()
+{
+	CU_pSuite suite = CU_add_suite("Allocation Budget Tests", setupAllocTests, cleanupAllocTests);
+	CU_ADD_TEST(suite, callsStayInAllocationBudgets);
+	CU_ADD_TEST(suite, callerBuiltLinksAreFreed);
+}
@@ -18,6 +18,7 @@
 #define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
@@ -96,6 +97,7 @@ static int cleanupTests()
 
 	unlink("test.stdout");
 	unlink("test.stderr");
+	unlink(libalts_get_generation_path());
 
 	return 0;
 }
@@ -274,6 +276,45 @@ Alternatives: 3\n\
 	CU_ASSERT_EQUAL(libalts_read_configured_priority(binary_name, &src), 0);
 }
 
+static void touchAndSystemOverridesBumpGeneration()
+{
+	char *args_touch[] = {"app", "--touch"};
+	char *args_set[] = {"app", "-s", "-n", "multiple_alts", "-p", "20"};
+	char *args_reset[] = {"app", "-s", "-n", "multiple_alts"};
+	char *args_user_set[] = {"app", "-u", "-n", "multiple_alts", "-p", "20"};
+	unsigned long long generation, new_generation;
+	struct stat st;
+
+	CU_ASSERT_EQUAL(libalts_get_generation(&generation), 0);
+
+	CU_ASSERT_EQUAL(WRAP_CALL(args_touch), 0);
+	CU_ASSERT_EQUAL(libalts_get_generation(&new_generation), 0);
+	CU_ASSERT_EQUAL(new_generation, generation + 1);
+	CU_ASSERT_EQUAL(stat(libalts_get_generation_path(), &st), 0);
+
+	CU_ASSERT_EQUAL(WRAP_CALL(args_set), 0);
+	CU_ASSERT_EQUAL(libalts_get_generation(&new_generation), 0);
+	CU_ASSERT_EQUAL(new_generation, generation + 2);
+
+	CU_ASSERT_EQUAL(WRAP_CALL(args_reset), 0);
+	CU_ASSERT_EQUAL(libalts_get_generation(&new_generation), 0);
+	CU_ASSERT_EQUAL(new_generation, generation + 3);
+
+	// user overrides are not part of the generation
+	CU_ASSERT_EQUAL(WRAP_CALL(args_user_set), 0);
+	CU_ASSERT_EQUAL(libalts_get_generation(&new_generation), 0);
+	CU_ASSERT_EQUAL(new_generation, generation + 3);
+
+	// a stamp that cannot be replaced fails the system override write
+	CU_ASSERT_EQUAL_FATAL(unlink(libalts_get_generation_path()), 0);
+	CU_ASSERT_EQUAL_FATAL(mkdir(libalts_get_generation_path(), 0755), 0);
+	CU_ASSERT_EQUAL(libalts_write_binary_configured_priority_to_file("multiple_alts", 20, libalts_get_system_config_path()), -1);
+	CU_ASSERT_NOT_EQUAL(WRAP_CALL(args_touch), 0);
+	CU_ASSERT_EQUAL(rmdir(libalts_get_generation_path()), 0);
+	CU_ASSERT_EQUAL(libalts_read_binary_configured_priority_from_file("multiple_alts", libalts_get_system_config_path()), 20);
+	CU_ASSERT_EQUAL(WRAP_CALL(args_reset), 0);
+}
+
 extern void setConfigDirectory(const char *);
 static int setupGroupTests()
 {
@@ -283,8 +324,9 @@ static int setupGroupTests()
 
 static int restoreGroupTestsAndRemoveIOFiles()
 {
+	int ret = cleanupTests();
 	setConfigDirectory(CONFIG_DIR);
-	return cleanupTests();
+	return ret;
 }
 
 static void listSpecificProgramInAGroup()
@@ -455,9 +497,10 @@ static int setupExecTests()
 
 static int cleanupExecTests()
 {
+	int ret = cleanupTests();
 	setConfigDirectory(CONFIG_DIR);
 	//unsetenv("LIBALTERNATIVES_DEBUG");
-	return cleanupTests();
+	return ret;
 }
 
 static void failedExecOfUnknown()
@@ -527,6 +570,224 @@ static void validExecCommandReplacedArgv0()
 	}
 }
 
+static void validExecScript()
+{
+	char *command_script[] = { "/usr/path/script49", NULL };
+	pid_t child_pid = fork();
+	int status = 1000;
+
+	switch (child_pid) {
+		case -1:
+			CU_ASSERT_FATAL(-1);
+			return;
+		case 0:
+			libalts_exec_default(command_script);
+			exit(100);
+		default:
+			CU_ASSERT_EQUAL_FATAL(wait(&status), child_pid);
+			CU_ASSERT(WIFEXITED(status));
+			CU_ASSERT_EQUAL(WEXITSTATUS(status), 0);
+	}
+}
+
+static int execDefaultInChild(char *argv[])
+{
+	pid_t child_pid = fork();
+	int status = 1000;
+
+	switch (child_pid) {
+		case -1:
+			return -1;
+		case 0:
+			libalts_exec_default(argv);
+			exit(100);
+		default:
+			if (waitpid(child_pid, &status, 0) != child_pid || !WIFEXITED(status))
+				return -1;
+			return WEXITSTATUS(status);
+	}
+}
+
+// returns the field of a cache entry that follows n colons, or NULL
+static char* cacheEntryField(char *entry, int n)
+{
+	for (; n > 0 && entry != NULL; n--) {
+		entry = strchr(entry, ':');
+		if (entry != NULL)
+			entry++;
+	}
+	return entry;
+}
+
+static void inheritedCacheIsUsedWhileValid()
+{
+	char *command[] = { "/usr/path/test42", NULL };
+	char cache[1024];
+	const char *entry;
+
+	setenv("LIBALTERNATIVES_CACHE", "", 1);
+	CU_ASSERT_EQUAL(libalts_export_inherited_cache("test42"), 0);
+	CU_ASSERT_EQUAL(libalts_export_inherited_cache("not_there"), -1);
+
+	entry = getenv("LIBALTERNATIVES_CACHE");
+	CU_ASSERT_EQUAL_FATAL(strncmp(entry, "test42:0:", 9), 0);
+	CU_ASSERT_PTR_NULL(strchr(entry, '\n'));
+	CU_ASSERT_STRING_EQUAL(strrchr(entry, ':'), ":/usr/bin/false");
+
+	// point the still valid entry elsewhere to see it is used for exec
+	snprintf(cache, sizeof(cache), "%.*s/usr/bin/true", (int)(strrchr(entry, ':') - entry + 1), entry);
+	setenv("LIBALTERNATIVES_CACHE", cache, 1);
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 0);
+
+	// entry with a different directory timestamp is ignored
+	cache[9] = cache[9] == '1' ? '2' : '1';
+	setenv("LIBALTERNATIVES_CACHE", cache, 1);
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 1);
+	cache[9] = cache[9] == '1' ? '2' : '1';
+
+	// as is one with a different change time of the options file, which
+	// is all that editing it in place changes
+	char *file_ctime = cacheEntryField(cache, 7);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(file_ctime);
+	file_ctime[0] = file_ctime[0] == '1' ? '2' : '1';
+	setenv("LIBALTERNATIVES_CACHE", cache, 1);
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 1);
+
+	unsetenv("LIBALTERNATIVES_CACHE");
+}
+
+static void traceLineIsWrittenWhenEnabled()
+{
+	char *command[] = { "/usr/path/test42", NULL };
+	char trace_path[] = "/tmp/libalternatives_trace_XXXXXX";
+	char trace[4096];
+
+	int fd = mkstemp(trace_path);
+	CU_ASSERT_FATAL(fd >= 0);
+
+	// test42 executes /usr/bin/false
+	setenv("LIBALTERNATIVES_TRACE_FILE", trace_path, 1);
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 1);
+	setenv("LIBALTERNATIVES_TRACE", "1", 1);
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 1);
+	unsetenv("LIBALTERNATIVES_TRACE");
+	unsetenv("LIBALTERNATIVES_TRACE_FILE");
+
+	const ssize_t len = read(fd, trace, sizeof(trace) - 1);
+	close(fd);
+	unlink(trace_path);
+	CU_ASSERT_FATAL(len > 0);
+	trace[len] = '\0';
+
+	// only the traced execution, as a single line
+	CU_ASSERT(strchr(trace, '\n') == trace + len - 1);
+	CU_ASSERT_EQUAL(strncmp(trace, "libalternatives-trace binary=\"test42\" ", 38), 0);
+	CU_ASSERT_PTR_NOT_NULL(strstr(trace, " source=config "));
+	CU_ASSERT_PTR_NOT_NULL(strstr(trace, " user_config_ns="));
+	CU_ASSERT_PTR_NOT_NULL(strstr(trace, " system_config_ns="));
+	CU_ASSERT_PTR_NOT_NULL(strstr(trace, " dir_scan_ns="));
+	CU_ASSERT_PTR_NOT_NULL(strstr(trace, " options_parse_ns="));
+	CU_ASSERT_PTR_NOT_NULL(strstr(trace, " pre_exec_ns="));
+	CU_ASSERT_PTR_NOT_NULL(strstr(trace, " total_ns="));
+	CU_ASSERT_PTR_NOT_NULL(strstr(trace, " target=\"/usr/bin/false\""));
+}
+
+extern void setCapturePath(const char *path);
+static void captureRecordsOutermostCalls()
+{
+	char *command[] = { "/usr/path/test42", NULL };
+	char *unknown_command[] = { "/usr/path/not_there", NULL };
+	char capture_path[] = "/tmp/libalternatives_capture_XXXXXX";
+	char capture[4096], expected[4096];
+	struct AlternativeLink *alts;
+
+	int fd = mkstemp(capture_path);
+	CU_ASSERT_FATAL(fd >= 0);
+
+	setCapturePath(capture_path);
+	// reads the overrides with another public function
+	const int priority = libalts_read_configured_priority("test42", NULL);
+	CU_ASSERT_EQUAL(libalts_load_exact_priority_binary_alternatives("test42", 8, &alts), 0);
+	libalts_free_alternatives_ptr(&alts);
+	// test42 executes /usr/bin/false
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 1);
+	CU_ASSERT_EQUAL(execDefaultInChild(unknown_command), 100);
+	setCapturePath(NULL);
+	libalts_read_configured_priority("test42", NULL);
+
+	const ssize_t len = read(fd, capture, sizeof(capture) - 1);
+	close(fd);
+	unlink(capture_path);
+	CU_ASSERT_FATAL(len > 0);
+	capture[len] = '\0';
+
+	snprintf(expected, sizeof(expected),
+	         "read_configured_priority\ttest42\t0\t%d\n"
+	         "load_exact_priority_binary_alternatives\ttest42\t8\t0\n"
+	         "exec_default\ttest42\t0\t0\n"
+	         "exec_default\tnot_there\t0\t-1\n", priority);
+	CU_ASSERT_STRING_EQUAL(capture, expected);
+}
+
+extern void setUsageEnabled(int enabled);
+
+static void usageIsCountedWhileEnabled()
+{
+	char *command[] = { "/usr/path/test42", NULL };
+	struct LibaltsUsage *usage;
+	size_t size;
+
+	unlink(libalts_get_usage_path());
+	setUsageEnabled(1);
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 1);
+	CU_ASSERT_EQUAL(libalts_load_usage(&usage, &size), -1);
+	CU_ASSERT_EQUAL(errno, ENOENT);
+
+	// the file alone does not enable counting
+	CU_ASSERT_EQUAL_FATAL(libalts_reset_usage(), 0);
+	setUsageEnabled(0);
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 1);
+	setUsageEnabled(1);
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 1);
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 1);
+	CU_ASSERT_EQUAL_FATAL(libalts_load_usage(&usage, &size), 0);
+	CU_ASSERT_EQUAL(size, 1);
+	if (size == 1) {
+		CU_ASSERT_STRING_EQUAL(usage[0].binary_name, "test42");
+		CU_ASSERT_EQUAL(usage[0].priority, 10);
+		CU_ASSERT_EQUAL(usage[0].count, 2);
+	}
+	free(usage);
+
+	// a locked slot drops the count instead of waiting
+	struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 0 };
+	const int fd = open(libalts_get_usage_path(), O_RDWR | O_CLOEXEC);
+	CU_ASSERT_FATAL(fd >= 0);
+	CU_ASSERT_EQUAL(fcntl(fd, F_OFD_SETLK, &lock), 0);
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 1);
+	close(fd);
+	CU_ASSERT_EQUAL_FATAL(libalts_load_usage(&usage, &size), 0);
+	CU_ASSERT_EQUAL(size, 1);
+	if (size == 1)
+		CU_ASSERT_EQUAL(usage[0].count, 2);
+	free(usage);
+
+	// restarts counting
+	CU_ASSERT_EQUAL(libalts_reset_usage(), 0);
+	CU_ASSERT_EQUAL(libalts_load_usage(&usage, &size), 0);
+	CU_ASSERT_EQUAL(size, 0);
+	free(usage);
+
+	// a truncated file skips the count without faulting
+	CU_ASSERT_EQUAL(truncate(libalts_get_usage_path(), 64), 0);
+	CU_ASSERT_EQUAL(execDefaultInChild(command), 1);
+	CU_ASSERT_EQUAL(libalts_load_usage(&usage, &size), -1);
+	CU_ASSERT_EQUAL(errno, EINVAL);
+
+	setUsageEnabled(0);
+	unlink(libalts_get_usage_path());
+}
+
 void addAlternativesAppTests()
 {
 	CU_pSuite suite = CU_add_suite_with_setup_and_teardown("Alternative App Tests", setupTests, cleanupTests, storeErrorCount, printOutputOnErrorIncrease);
@@ -537,6 +798,7 @@ void addAlternativesAppTests()
 	CU_ADD_TEST(suite, listAllAvailablePrograms);
 	CU_ADD_TEST(suite, listSpecificProgram);
 	CU_ADD_TEST(suite, adjustPriorityForSpecificProgram);
+	CU_ADD_TEST(suite, touchAndSystemOverridesBumpGeneration);
 
 	suite = CU_add_suite_with_setup_and_teardown("Alternative App with Groups Tests", setupGroupTests, restoreGroupTestsAndRemoveIOFiles, storeErrorCount, printOutputOnErrorIncrease);
 	CU_ADD_TEST(suite, listSpecificProgramInAGroup);
@@ -548,4 +810,9 @@ void addAlternativesAppTests()
 	CU_ADD_TEST(suite, validExecCommand);
 	CU_ADD_TEST(suite, validExecCommandKeepArgv0);
 	CU_ADD_TEST(suite, validExecCommandReplacedArgv0);
+	CU_ADD_TEST(suite, validExecScript);
+	CU_ADD_TEST(suite, inheritedCacheIsUsedWhileValid);
+	CU_ADD_TEST(suite, traceLineIsWrittenWhenEnabled);
+	CU_ADD_TEST(suite, captureRecordsOutermostCalls);
+	CU_ADD_TEST(suite, usageIsCountedWhileEnabled);
 }
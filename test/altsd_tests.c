@@ -0,0 +1,251 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <ftw.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <CUnit/CUnit.h>
+
+#include "../src/libalternatives.h"
+
+extern void setConfigDirectory(const char *);
+extern void setConfigPath(const char *config_path);
+extern void setResolverSocketPath(const char *path);
+extern void setAltsdConfigDirectory(const char *path);
+extern int altsd_main(int argc, char *argv[]);
+
+static char tree_path[] = "/tmp/libalternatives_altsd_XXXXXX";
+static char empty_path[512], socket_path[512], user_config_path[512];
+static pid_t daemon_pid;
+
+static void writeTreeFile(const char *name, const char *content)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", tree_path, name);
+
+	FILE *f = fopen(path, "w");
+	fputs(content, f);
+	fclose(f);
+}
+
+static int removeTreeEntry(const char *path, __attribute__((unused)) const struct stat *st, __attribute__((unused)) int flag, __attribute__((unused)) struct FTW *ftw)
+{
+	return remove(path);
+}
+
+static void sleepMs(long ms)
+{
+	struct timespec ts = { 0, ms * 1000000 };
+	nanosleep(&ts, NULL);
+}
+
+static int setupAltsdTests()
+{
+	char path[512];
+
+	if (mkdtemp(tree_path) == NULL)
+		return -1;
+
+	snprintf(path, sizeof(path), "%s/tree", tree_path);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/tree/editor", tree_path);
+	mkdir(path, 0755);
+	snprintf(empty_path, sizeof(empty_path), "%s/empty", tree_path);
+	mkdir(empty_path, 0755);
+	snprintf(socket_path, sizeof(socket_path), "%s/altsd.socket", tree_path);
+	snprintf(user_config_path, sizeof(user_config_path), "%s/user.conf", tree_path);
+
+	writeTreeFile("tree/editor/10.conf", "binary=/usr/bin/vi\nman=vi.1\n");
+	writeTreeFile("tree/editor/20.conf", "binary=/usr/bin/emacs\nman=emacs.1\n");
+
+	// entries that the highest priority does not simply select
+	snprintf(path, sizeof(path), "%s/tree/odd", tree_path);
+	mkdir(path, 0755);
+	writeTreeFile("tree/odd/5.conf", "binary=/usr/bin/odd5\n");
+	writeTreeFile("tree/odd/0.conf", "binary=/usr/bin/odd0\n");
+	writeTreeFile("tree/odd/-20.conf", "binary=/usr/bin/odd-20\n");
+	writeTreeFile("tree/odd/legacy.conf", "binary=/usr/bin/legacy\n");
+	snprintf(path, sizeof(path), "%s/tree/zero", tree_path);
+	mkdir(path, 0755);
+	writeTreeFile("tree/zero/0.conf", "binary=/usr/bin/zero\n");
+	snprintf(path, sizeof(path), "%s/tree/broken", tree_path);
+	mkdir(path, 0755);
+	writeTreeFile("tree/broken/10.conf", "binary=/usr/bin/broken10\n");
+	writeTreeFile("tree/broken/20.conf", "no binary here\n");
+
+	snprintf(path, sizeof(path), "%s/tree", tree_path);
+	setAltsdConfigDirectory(path);
+	setConfigDirectory(path);
+	setConfigPath(user_config_path);
+	setResolverSocketPath(socket_path);
+
+	daemon_pid = fork();
+	if (daemon_pid == 0) {
+		char *argv[] = { "altsd", "-s", socket_path, NULL };
+		_exit(altsd_main(3, argv));
+	}
+
+	for (int i=0; i<100 && access(socket_path, F_OK) != 0; i++)
+		sleepMs(10);
+
+	// the daemon answers even if our own config directory is empty
+	setConfigDirectory(empty_path);
+	return daemon_pid < 0 ? -1 : 0;
+}
+
+static int cleanupAltsdTests()
+{
+	if (daemon_pid > 0) {
+		kill(daemon_pid, SIGTERM);
+		waitpid(daemon_pid, NULL, 0);
+	}
+
+	setResolverSocketPath(NULL);
+	setConfigPath(NULL);
+	setConfigDirectory(CONFIG_DIR);
+	return nftw(tree_path, removeTreeEntry, 8, FTW_DEPTH | FTW_PHYS);
+}
+
+// manpages are resolved through the same path as exec
+static int isFirstManpage(const char *binary_name, const char *manpage)
+{
+	char **manpages = libalts_get_default_manpages(binary_name);
+	const int ret = (manpages[0] != NULL && strcmp(manpages[0], manpage) == 0);
+
+	for (char **ptr = manpages; *ptr != NULL; ptr++)
+		free(*ptr);
+	free(manpages);
+	return ret;
+}
+
+static int waitForFirstManpage(const char *binary_name, const char *manpage)
+{
+	for (int i=0; i<100; i++) {
+		if (isFirstManpage(binary_name, manpage))
+			return 1;
+		sleepMs(10);
+	}
+
+	return 0;
+}
+
+static void resolvedByDaemon()
+{
+	CU_ASSERT(isFirstManpage("editor", "emacs.1"));
+	CU_ASSERT(!isFirstManpage("pager", "less.1"));
+}
+
+// returns the result of resolving binary_name, and its target in target
+static int resolveTarget(const char *binary_name, char *target, size_t size)
+{
+	char *resolved = NULL;
+	int options;
+
+	const int ret = libalts_resolve_default_binary(binary_name, &resolved, &options);
+	snprintf(target, size, "%s", ret == 0 ? resolved : "");
+	free(resolved);
+	return ret;
+}
+
+static void daemonSelectsAsTheLibrary()
+{
+	const char *const names[] = { "editor", "odd", "zero", "broken", "not_there", NULL };
+	char path[512], no_socket_path[512];
+	char daemon_target[PATH_MAX], library_target[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/tree", tree_path);
+	snprintf(no_socket_path, sizeof(no_socket_path), "%s/no.socket", tree_path);
+
+	for (const char *const *name = names; *name != NULL; name++) {
+		const int daemon_ret = resolveTarget(*name, daemon_target, sizeof(daemon_target));
+
+		setResolverSocketPath(no_socket_path);
+		setConfigDirectory(path);
+		const int library_ret = resolveTarget(*name, library_target, sizeof(library_target));
+		setConfigDirectory(empty_path);
+		setResolverSocketPath(socket_path);
+
+		CU_ASSERT_EQUAL(daemon_ret, library_ret);
+		CU_ASSERT_STRING_EQUAL(daemon_target, library_target);
+	}
+
+	CU_ASSERT_EQUAL(resolveTarget("odd", daemon_target, sizeof(daemon_target)), 0);
+	CU_ASSERT_STRING_EQUAL(daemon_target, "/usr/bin/odd5");
+}
+
+static void userOverrideIsPassedAlong()
+{
+	CU_ASSERT_EQUAL(libalts_write_binary_configured_priority_to_file("editor", 10, user_config_path), 0);
+	CU_ASSERT(isFirstManpage("editor", "vi.1"));
+
+	// a missing priority falls back to the highest, as without the daemon
+	CU_ASSERT_EQUAL(libalts_write_binary_configured_priority_to_file("editor", 15, user_config_path), 0);
+	CU_ASSERT(isFirstManpage("editor", "emacs.1"));
+
+	unlink(user_config_path);
+}
+
+static void changesAreWatched()
+{
+	char path[512];
+
+	writeTreeFile("tree/editor/30.conf", "binary=/usr/bin/nano\nman=nano.1\n");
+	CU_ASSERT(waitForFirstManpage("editor", "nano.1"));
+
+	snprintf(path, sizeof(path), "%s/tree/pager", tree_path);
+	mkdir(path, 0755);
+	writeTreeFile("tree/pager/5.conf", "binary=/usr/bin/less\nman=less.1\n");
+	CU_ASSERT(waitForFirstManpage("pager", "less.1"));
+
+	snprintf(path, sizeof(path), "%s/tree/editor/30.conf", tree_path);
+	unlink(path);
+	CU_ASSERT(waitForFirstManpage("editor", "emacs.1"));
+}
+
+static void fallbackWithoutDaemon()
+{
+	char path[512];
+
+	kill(daemon_pid, SIGTERM);
+	CU_ASSERT_EQUAL(waitpid(daemon_pid, NULL, 0), daemon_pid);
+	daemon_pid = 0;
+	CU_ASSERT_EQUAL(access(socket_path, F_OK), -1);
+
+	CU_ASSERT(!isFirstManpage("editor", "emacs.1"));
+
+	snprintf(path, sizeof(path), "%s/tree", tree_path);
+	setConfigDirectory(path);
+	CU_ASSERT(isFirstManpage("editor", "emacs.1"));
+}
+
+void addAltsdTests()
+{
+	CU_pSuite suite = CU_add_suite("Resolver Daemon Tests", setupAltsdTests, cleanupAltsdTests);
+	CU_ADD_TEST(suite, resolvedByDaemon);
+	CU_ADD_TEST(suite, daemonSelectsAsTheLibrary);
+	CU_ADD_TEST(suite, userOverrideIsPassedAlong);
+	CU_ADD_TEST(suite, changesAreWatched);
+	CU_ADD_TEST(suite, fallbackWithoutDaemon);
+}
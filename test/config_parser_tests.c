@@ -142,6 +142,24 @@ static void parsingNoneDigitalValue()
   doneConfigParser(state);
 }
 
+static void parsingOutOfRangeValue()
+{
+  const char entries[] = "editor=3000000000\neditor=5";
+
+  CU_ASSERT_PTR_NOT_NULL(state = initConfigParser("editor"));
+  CU_ASSERT_EQUAL(parseConfigData(entries, state),5);
+  doneConfigParser(state);
+}
+
+static void parsingEmptyKey()
+{
+  const char entries[] = "=5\n  =6\neditor=7";
+
+  CU_ASSERT_PTR_NOT_NULL(state = initConfigParser("editor"));
+  CU_ASSERT_EQUAL(parseConfigData(entries, state),7);
+  doneConfigParser(state);
+}
+
 static void  duplicateUseFirstEntry()
 {
   const char entries[] = "\n\n editor=5 \n editor=10 \n";
@@ -297,6 +315,8 @@ void addConfigParserTests()
   CU_ADD_TEST(tests, parsingWithWhitespaces1);
   CU_ADD_TEST(tests, parsingWithWhitespaces2);
   CU_ADD_TEST(tests, parsingNoneDigitalValue);
+  CU_ADD_TEST(tests, parsingOutOfRangeValue);
+  CU_ADD_TEST(tests, parsingEmptyKey);
   CU_ADD_TEST(tests, duplicateUseFirstEntry);
   CU_ADD_TEST(tests, parsingWithComment);
   CU_ADD_TEST(tests, similarBinaries);
@@ -0,0 +1,3 @@
+#!/bin/sh
+# executed through alternatives in place of script49
+test "$(basename "$0")" = exec_script_helper.sh
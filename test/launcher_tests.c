@@ -0,0 +1,172 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <CUnit/CUnit.h>
+
+#include "../src/libalternatives.h"
+
+extern void setConfigDirectory(const char *);
+extern void setConfigPath(const char *config_path);
+
+// the test library uses /usr/bin/false in place of alts, so a stale
+// launcher exits with 1
+static char tree_path[] = "/tmp/libalternatives_launcher_XXXXXX";
+static char launcher_path[512], user_config_path[512];
+static char *saved_config_home;
+
+static void writeTreeFile(const char *name, const char *content)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", tree_path, name);
+
+	FILE *f = fopen(path, "w");
+	fputs(content, f);
+	fclose(f);
+}
+
+static void setTreeTime(const char *name, time_t when)
+{
+	char path[512];
+	struct timespec times[2] = {{when, 0}, {when, 0}};
+
+	snprintf(path, sizeof(path), "%s/%s", tree_path, name);
+	utimensat(AT_FDCWD, path, times, 0);
+}
+
+static int removeTreeEntry(const char *path, __attribute__((unused)) const struct stat *st, __attribute__((unused)) int flag, __attribute__((unused)) struct FTW *ftw)
+{
+	return remove(path);
+}
+
+static int setupLauncherTests()
+{
+	char path[512];
+
+	if (mkdtemp(tree_path) == NULL)
+		return -1;
+
+	snprintf(path, sizeof(path), "%s/tool", tree_path);
+	mkdir(path, 0755);
+	writeTreeFile("tool/10.conf", "binary=/usr/bin/true\n");
+	setTreeTime("tool", 1000000);
+
+	snprintf(launcher_path, sizeof(launcher_path), "%s/launcher", tree_path);
+	// launchers find the user override through the environment
+	snprintf(user_config_path, sizeof(user_config_path), "%s/libalternatives.conf", tree_path);
+	if (getenv("XDG_CONFIG_HOME") != NULL)
+		saved_config_home = strdup(getenv("XDG_CONFIG_HOME"));
+	setenv("XDG_CONFIG_HOME", tree_path, 1);
+
+	setConfigDirectory(tree_path);
+	setConfigPath(user_config_path);
+	return 0;
+}
+
+static int cleanupLauncherTests()
+{
+	if (saved_config_home != NULL)
+		setenv("XDG_CONFIG_HOME", saved_config_home, 1);
+	else
+		unsetenv("XDG_CONFIG_HOME");
+	free(saved_config_home);
+
+	setConfigPath(NULL);
+	setConfigDirectory(CONFIG_DIR);
+	return nftw(tree_path, removeTreeEntry, 8, FTW_DEPTH | FTW_PHYS);
+}
+
+static int runLauncher(const char *argv1)
+{
+	char *argv[] = { "tool", (char*)argv1, NULL };
+	int status;
+	pid_t pid = fork();
+
+	if (pid == 0) {
+		execv(launcher_path, argv);
+		_exit(100);
+	}
+
+	if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+		return -1;
+	return WEXITSTATUS(status);
+}
+
+static void launcherExecsTarget()
+{
+	CU_ASSERT_EQUAL_FATAL(libalts_generate_launcher("tool", launcher_path), 0);
+	CU_ASSERT_EQUAL(access(launcher_path, X_OK), 0);
+	CU_ASSERT_EQUAL(runLauncher(NULL), 0);
+}
+
+static void changedDirectoryMakesLauncherStale()
+{
+	writeTreeFile("tool/20.conf", "binary=./build/test/argv_replaced_helper\noptions=KeepArgv0\n");
+	setTreeTime("tool", 2000000);
+	CU_ASSERT_EQUAL(runLauncher("tool"), 1);
+
+	// regenerated launcher keeps argv[0] as the binary name
+	CU_ASSERT_EQUAL_FATAL(libalts_generate_launcher("tool", launcher_path), 0);
+	CU_ASSERT_EQUAL(runLauncher("tool"), 0);
+}
+
+static void editedOptionsFileMakesLauncherStale()
+{
+	// rewritten in place, so the directory keeps its time
+	writeTreeFile("tool/20.conf", "binary=/usr/bin/true\n");
+	CU_ASSERT_EQUAL(runLauncher("tool"), 1);
+
+	CU_ASSERT_EQUAL_FATAL(libalts_generate_launcher("tool", launcher_path), 0);
+	CU_ASSERT_EQUAL(runLauncher("tool"), 0);
+}
+
+static void userOverrideMakesLauncherStale()
+{
+	CU_ASSERT_EQUAL(libalts_write_binary_configured_priority_to_file("tool", 10, user_config_path), 0);
+	CU_ASSERT_EQUAL(runLauncher("tool"), 1);
+
+	unlink(user_config_path);
+	CU_ASSERT_EQUAL(runLauncher("tool"), 0);
+}
+
+static void unknownBinaryHasNoLauncher()
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/not_there", tree_path);
+
+	CU_ASSERT_EQUAL(libalts_generate_launcher("not_there", path), -1);
+	CU_ASSERT_EQUAL(errno, ENOENT);
+	CU_ASSERT_EQUAL(access(path, F_OK), -1);
+}
+
+void addLauncherTests()
+{
+	CU_pSuite suite = CU_add_suite("Launcher Tests", setupLauncherTests, cleanupLauncherTests);
+	CU_ADD_TEST(suite, launcherExecsTarget);
+	CU_ADD_TEST(suite, changedDirectoryMakesLauncherStale);
+	CU_ADD_TEST(suite, editedOptionsFileMakesLauncherStale);
+	CU_ADD_TEST(suite, userOverrideMakesLauncherStale);
+	CU_ADD_TEST(suite, unknownBinaryHasNoLauncher);
+}
@@ -15,6 +15,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <CUnit/CUnit.h>
 #include "../src/libalternatives.h"
 #include "../src/parser.h"
@@ -29,9 +30,7 @@ static struct AlternativeLink *result = NULL;
 
 static void freeResults()
 {
-	for (struct AlternativeLink *link=result; link != NULL && link->type != ALTLINK_EOL; link++)
-		free((void*)link->target);
-
+	// targets are in the same allocation
 	free(result);
 	result = NULL;
 }
@@ -283,6 +282,102 @@ static void parseLongGroupsLine()
 	CU_ASSERT_EQUAL(r->type, ALTLINK_EOL);
 }
 
+static void parseTokenSplitBetweenReads()
+{
+	const char data[] = "binary=/usr/bin/vim\nman=vim.1";
+
+	CU_ASSERT_PTR_NOT_NULL(state = initOptionsParser());
+	CU_ASSERT_EQUAL(parseOptionsData(data, 2, state), 0);
+	CU_ASSERT_EQUAL(parseOptionsData(data+2, 19, state), 0);
+	CU_ASSERT_EQUAL(parseOptionsData(data+21, sizeof(data)-22, state), 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(result = doneOptionsParser(10, state));
+
+	CU_ASSERT_EQUAL(result[0].type, ALTLINK_BINARY);
+	CU_ASSERT_STRING_EQUAL(result[0].target, "/usr/bin/vim");
+	CU_ASSERT_EQUAL(result[1].type, ALTLINK_MANPAGE);
+	CU_ASSERT_STRING_EQUAL(result[1].target, "vim.1");
+	CU_ASSERT_EQUAL(result[2].type, ALTLINK_EOL);
+}
+
+static void parseTooLongValue()
+{
+	char data[0x10000 + 16] = "binary=/";
+
+	memset(data + 8, 'a', sizeof(data) - 9);
+	data[sizeof(data) - 1] = '\0';
+	CU_ASSERT_PTR_NOT_NULL(state = initOptionsParser());
+	CU_ASSERT_EQUAL(parseOptionsData(data, sizeof(data)-1, state), -1);
+	CU_ASSERT_PTR_NULL(result = doneOptionsParser(10, state));
+}
+
+// returns 1 if all targets follow the links, in the same allocation
+static int targetsFollowLinks(const struct AlternativeLink *links)
+{
+	const struct AlternativeLink *end = links;
+
+	while (end->type != ALTLINK_EOL)
+		end++;
+	for (const struct AlternativeLink *link=links; link<end; link++) {
+		if (link->target < (const char*)(end + 1) || (link > links && link->target <= link[-1].target))
+			return 0;
+	}
+	return 1;
+}
+
+static void parseBufferAsParsedInReads()
+{
+	const char data[] = "binary=/usr/bin/ls\r\nman= ls.1 ,dir.1\ngroup=ls,dir\noptions=KeepArgv0\n";
+	struct AlternativeLink *links;
+
+	CU_ASSERT_PTR_NOT_NULL(state = initOptionsParser());
+	CU_ASSERT_EQUAL(parseOptionsData(data, 7, state), 0);
+	CU_ASSERT_EQUAL(parseOptionsData(data+7, sizeof(data)-1-7, state), 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(result = doneOptionsParser(10, state));
+	CU_ASSERT_TRUE(targetsFollowLinks(result));
+
+	CU_ASSERT_EQUAL(parseOptionsBuffer(data, sizeof(data)-1, 10, &links), 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(links);
+	CU_ASSERT_TRUE(targetsFollowLinks(links));
+
+	for (int i=0; i<6; i++) {
+		CU_ASSERT_EQUAL(links[i].type, result[i].type);
+		if (links[i].type == ALTLINK_EOL || result[i].type == ALTLINK_EOL)
+			break;
+		CU_ASSERT_STRING_EQUAL(links[i].target, result[i].target);
+		CU_ASSERT_EQUAL(links[i].priority, 10);
+		CU_ASSERT_EQUAL(links[i].options, ALTLINK_OPTIONS_KEEPARGV0);
+	}
+	CU_ASSERT_STRING_EQUAL(links[2].target, "dir.1");
+	CU_ASSERT_EQUAL(links[5].type, ALTLINK_EOL);
+	free(links);
+}
+
+static void parseBufferUpToItsBounds()
+{
+	// every delimiter starts a link, and the value ends the input
+	const char data[] = "group=a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,qrstuvwxyz";
+
+	CU_ASSERT_EQUAL(parseOptionsBuffer(data, sizeof(data)-1, 10, &result), 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(result);
+	CU_ASSERT_EQUAL(result[16].type, ALTLINK_GROUP);
+	CU_ASSERT_STRING_EQUAL(result[16].target, "qrstuvwxyz");
+	CU_ASSERT_EQUAL(result[17].type, ALTLINK_EOL);
+}
+
+static void parseBufferWithoutLinks()
+{
+	const char data[] = "options=KeepArgv0";
+
+	CU_ASSERT_EQUAL(parseOptionsBuffer("", 0, 10, &result), 0);
+	CU_ASSERT_PTR_NULL(result);
+	CU_ASSERT_EQUAL(parseOptionsBuffer(data, sizeof(data)-1, 10, &result), 0);
+	CU_ASSERT_PTR_NULL(result);
+	CU_ASSERT_EQUAL(parseOptionsBuffer(data, 3, 10, &result), -1);
+	CU_ASSERT_PTR_NULL(result);
+	CU_ASSERT_EQUAL(parseOptionsBuffer("binary /usr/bin/ls", 18, 10, &result), -1);
+	CU_ASSERT_PTR_NULL(result);
+}
+
 void addOptionsParserTests()
 {
 	CU_pSuite tests = CU_add_suite_with_setup_and_teardown("parser",
@@ -306,4 +401,9 @@ void addOptionsParserTests()
 	CU_ADD_TEST(tests, parseWithBadOptions);
 	CU_ADD_TEST(tests, parseWithGoodOptions);
 	CU_ADD_TEST(tests, parseLongGroupsLine);
+	CU_ADD_TEST(tests, parseTokenSplitBetweenReads);
+	CU_ADD_TEST(tests, parseTooLongValue);
+	CU_ADD_TEST(tests, parseBufferAsParsedInReads);
+	CU_ADD_TEST(tests, parseBufferUpToItsBounds);
+	CU_ADD_TEST(tests, parseBufferWithoutLinks);
 }
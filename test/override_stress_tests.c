@@ -0,0 +1,243 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <CUnit/CUnit.h>
+
+#include "../src/libalternatives.h"
+
+extern void setConfigPath(const char *config_path);
+
+/* Concurrent writers and readers of one user override file.
+ *
+ * Every writer process owns one entry and writes it with increasing
+ * priorities, reading it back after each write. As no other process
+ * writes that entry, reading back anything else is a lost update, made
+ * by a writer that saved the file from an older read. Reader processes
+ * meanwhile read the entries through libalts_read_configured_priority(),
+ * which must never go back to an older priority or lose a written entry,
+ * and read the file itself, whose every line must be a whole entry.
+ * Throughput of both is printed.
+ */
+
+#define WRITERS 4
+#define READERS 4
+#define WRITES 100
+
+struct StressState
+{
+	int stop;
+	unsigned long writes;
+	unsigned long write_failures;
+	unsigned long lost_updates;
+	unsigned long reads;
+	unsigned long stale_reads;
+	unsigned long torn_reads;
+};
+
+static char override_dir[] = "/tmp/libalternatives_stress_XXXXXX";
+static char override_path[sizeof(override_dir) + 32];
+
+static void entryName(int writer, char *name, size_t size)
+{
+	snprintf(name, size, "stress_writer%d", writer);
+}
+
+static void runWriter(int writer, int start_fd, struct StressState *state)
+{
+	char name[32], c;
+
+	entryName(writer, name, sizeof(name));
+	while (read(start_fd, &c, 1) < 0 && errno == EINTR)
+		;
+	close(start_fd);
+
+	for (int priority=1; priority<=WRITES; priority++) {
+		if (libalts_write_binary_configured_priority_to_file(name, priority, override_path) != 0) {
+			__atomic_fetch_add(&state->write_failures, 1, __ATOMIC_RELAXED);
+			continue;
+		}
+		__atomic_fetch_add(&state->writes, 1, __ATOMIC_RELAXED);
+		if (libalts_read_binary_configured_priority_from_file(name, override_path) != priority)
+			__atomic_fetch_add(&state->lost_updates, 1, __ATOMIC_RELAXED);
+	}
+	_exit(0);
+}
+
+// returns 1 if every line of the override is a whole entry of a writer
+static int isWholeFile()
+{
+	char data[1024], *line, *lines = data;
+	ssize_t len;
+	int fd = open(override_path, O_RDONLY | O_CLOEXEC);
+
+	if (fd < 0)
+		return errno == ENOENT;
+	len = read(fd, data, sizeof(data) - 1);
+	close(fd);
+	if (len < 0)
+		return 0;
+	data[len] = '\0';
+
+	while ((line = strsep(&lines, "\n")) != NULL) {
+		int writer, priority, end = 0;
+
+		if (line[0] == '\0')
+			continue;
+		if (sscanf(line, "stress_writer%d=%d%n", &writer, &priority, &end) != 2 || line[end] != '\0' ||
+		    writer < 0 || writer >= WRITERS || priority < 1 || priority > WRITES)
+			return 0;
+	}
+	return 1;
+}
+
+static void runReader(int start_fd, struct StressState *state)
+{
+	int last_priority[WRITERS] = { 0 };
+	char name[32], c;
+
+	while (read(start_fd, &c, 1) < 0 && errno == EINTR)
+		;
+	close(start_fd);
+
+	for (int i=0; !__atomic_load_n(&state->stop, __ATOMIC_RELAXED); i++) {
+		const int writer = i % WRITERS;
+
+		entryName(writer, name, sizeof(name));
+		const int priority = libalts_read_configured_priority(name, NULL);
+		if (priority < last_priority[writer])
+			__atomic_fetch_add(&state->stale_reads, 1, __ATOMIC_RELAXED);
+		else
+			last_priority[writer] = priority;
+
+		if (!isWholeFile())
+			__atomic_fetch_add(&state->torn_reads, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&state->reads, 1, __ATOMIC_RELAXED);
+	}
+	_exit(0);
+}
+
+static int setupStressTests()
+{
+	if (mkdtemp(override_dir) == NULL)
+		return -1;
+	snprintf(override_path, sizeof(override_path), "%s/libalternatives.conf", override_dir);
+	setConfigPath(override_path);
+	return 0;
+}
+
+static int cleanupStressTests()
+{
+	setConfigPath(NULL);
+	unlink(override_path);
+	return rmdir(override_dir);
+}
+
+static void waitFor(pid_t pid)
+{
+	while (waitpid(pid, NULL, 0) < 0 && errno == EINTR)
+		;
+}
+
+static void concurrentWritersLoseNoUpdates()
+{
+	struct StressState *state = mmap(NULL, sizeof(struct StressState), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	pid_t writers[WRITERS], readers[READERS];
+	int start_pipe[2];
+	struct timespec start, end;
+
+	CU_ASSERT_FATAL(state != MAP_FAILED);
+	CU_ASSERT_FATAL(pipe(start_pipe) == 0);
+	fflush(NULL);
+
+	for (int i=0; i<WRITERS; i++) {
+		writers[i] = fork();
+		CU_ASSERT_FATAL(writers[i] >= 0);
+		if (writers[i] == 0) {
+			close(start_pipe[1]);
+			runWriter(i, start_pipe[0], state);
+		}
+	}
+	for (int i=0; i<READERS; i++) {
+		readers[i] = fork();
+		CU_ASSERT_FATAL(readers[i] >= 0);
+		if (readers[i] == 0) {
+			close(start_pipe[1]);
+			runReader(start_pipe[0], state);
+		}
+	}
+
+	// all are released at once
+	close(start_pipe[0]);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	close(start_pipe[1]);
+	for (int i=0; i<WRITERS; i++)
+		waitFor(writers[i]);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	__atomic_store_n(&state->stop, 1, __ATOMIC_RELAXED);
+	for (int i=0; i<READERS; i++)
+		waitFor(readers[i]);
+
+	const double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("\n  %d writers: %.0f writes/s, %d readers: %.0f reads/s\n",
+	       WRITERS, state->writes / seconds, READERS, state->reads / seconds);
+	if (state->write_failures || state->lost_updates || state->stale_reads || state->torn_reads)
+		printf("  %lu failed writes, %lu lost updates, %lu stale reads, %lu torn reads\n",
+		       state->write_failures, state->lost_updates, state->stale_reads, state->torn_reads);
+
+	CU_ASSERT_EQUAL(state->writes, WRITERS * WRITES);
+	CU_ASSERT_EQUAL(state->write_failures, 0);
+	CU_ASSERT_EQUAL(state->lost_updates, 0);
+	CU_ASSERT_EQUAL(state->stale_reads, 0);
+	CU_ASSERT_EQUAL(state->torn_reads, 0);
+
+	// every writer's last priority survived
+	for (int i=0; i<WRITERS; i++) {
+		char name[32];
+
+		entryName(i, name, sizeof(name));
+		CU_ASSERT_EQUAL(libalts_read_binary_configured_priority_from_file(name, override_path), WRITES);
+	}
+
+	// nothing but the override is left next to it, no lock or temporary file
+	DIR *dir = opendir(override_dir);
+	struct dirent *entry;
+	int files = 0;
+
+	CU_ASSERT_PTR_NOT_NULL_FATAL(dir);
+	while ((entry = readdir(dir)) != NULL)
+		if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+			files++;
+	closedir(dir);
+	CU_ASSERT_EQUAL(files, 1);
+	munmap(state, sizeof(struct StressState));
+}
+
+void addOverrideStressTests()
+{
+	CU_pSuite suite = CU_add_suite("Override Stress Tests", setupStressTests, cleanupStressTests);
+	CU_ADD_TEST(suite, concurrentWritersLoseNoUpdates);
+}
@@ -0,0 +1,240 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <ftw.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <CUnit/CUnit.h>
+
+#include "../src/libalternatives.h"
+
+extern void setConfigDirectory(const char *);
+extern void setConfigPath(const char *config_path);
+
+extern int preload_execv(const char *path, char *const argv[]);
+extern int preload_execve(const char *path, char *const argv[], char *const envp[]);
+extern int preload_execvp(const char *file, char *const argv[]);
+extern int preload_execl(const char *path, const char *arg, ...);
+extern int preload_posix_spawn(pid_t *pid, const char *path, const posix_spawn_file_actions_t *file_actions,
+                               const posix_spawnattr_t *attrp, char *const argv[], char *const envp[]);
+
+extern char **environ;
+
+// links point to an alts that is /usr/bin/false, so an exec that is not
+// resolved exits with 1
+static char tree_path[] = "/tmp/libalternatives_preload_XXXXXX";
+static char bin_path[256];
+static char *saved_config_home;
+
+static void writeTreeFile(const char *name, const char *content)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", tree_path, name);
+
+	FILE *f = fopen(path, "w");
+	fputs(content, f);
+	fclose(f);
+}
+
+static void makeTreeLink(const char *name, const char *target)
+{
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/%s", bin_path, name);
+	symlink(target, path);
+}
+
+static int removeTreeEntry(const char *path, __attribute__((unused)) const struct stat *st, __attribute__((unused)) int flag, __attribute__((unused)) struct FTW *ftw)
+{
+	return remove(path);
+}
+
+static int setupPreloadTests()
+{
+	char path[512];
+
+	if (mkdtemp(tree_path) == NULL)
+		return -1;
+
+	snprintf(path, sizeof(path), "%s/tool", tree_path);
+	mkdir(path, 0755);
+	writeTreeFile("tool/10.conf", "binary=./build/test/argv_replaced_helper\n");
+	snprintf(path, sizeof(path), "%s/keep", tree_path);
+	mkdir(path, 0755);
+	writeTreeFile("keep/10.conf", "binary=./build/test/argv_replaced_helper\noptions=KeepArgv0\n");
+
+	snprintf(bin_path, sizeof(bin_path), "%s/bin", tree_path);
+	mkdir(bin_path, 0755);
+	snprintf(path, sizeof(path), "%s/sbin", tree_path);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/sbin/alts", tree_path);
+	symlink("/usr/bin/false", path);
+	makeTreeLink("tool", path);
+	makeTreeLink("keep", path);
+	makeTreeLink("unknown", path);
+	makeTreeLink("true", "/usr/bin/true");
+
+	// alts would read the same user override with our environment
+	if (getenv("XDG_CONFIG_HOME") != NULL)
+		saved_config_home = strdup(getenv("XDG_CONFIG_HOME"));
+	setenv("XDG_CONFIG_HOME", tree_path, 1);
+	snprintf(path, sizeof(path), "%s/libalternatives.conf", tree_path);
+	setConfigDirectory(tree_path);
+	setConfigPath(path);
+	return 0;
+}
+
+static int cleanupPreloadTests()
+{
+	if (saved_config_home != NULL)
+		setenv("XDG_CONFIG_HOME", saved_config_home, 1);
+	else
+		unsetenv("XDG_CONFIG_HOME");
+	free(saved_config_home);
+	saved_config_home = NULL;
+	setConfigPath(NULL);
+	setConfigDirectory(CONFIG_DIR);
+	return nftw(tree_path, removeTreeEntry, 8, FTW_DEPTH | FTW_PHYS);
+}
+
+static int waitChild(pid_t pid)
+{
+	int status;
+
+	if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+		return -1;
+	return WEXITSTATUS(status);
+}
+
+// runs argv through preload_execve() with envp in a child
+static int runExecve(const char *name, char *const argv[], char *const envp[])
+{
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/%s", bin_path, name);
+
+	const pid_t pid = fork();
+	if (pid == 0) {
+		preload_execve(path, argv, envp);
+		_exit(100);
+	}
+
+	return waitChild(pid);
+}
+
+static void execveResolvesAltsLink()
+{
+	char *argv[] = { "tool", "argv_replaced_helper", NULL };
+	char *keep_argv[] = { "/some/dir/keep", "keep", NULL };
+
+	CU_ASSERT_EQUAL(runExecve("tool", argv, environ), 0);
+	CU_ASSERT_EQUAL(runExecve("keep", keep_argv, environ), 0);
+}
+
+static void execvpAndExeclResolveAltsLink()
+{
+	char path[1024];
+	char *argv[] = { "tool", "argv_replaced_helper", NULL };
+
+	pid_t pid = fork();
+	if (pid == 0) {
+		setenv("PATH", bin_path, 1);
+		preload_execvp("tool", argv);
+		_exit(100);
+	}
+	CU_ASSERT_EQUAL(waitChild(pid), 0);
+
+	snprintf(path, sizeof(path), "%s/tool", bin_path);
+	pid = fork();
+	if (pid == 0) {
+		preload_execl(path, "tool", "argv_replaced_helper", NULL);
+		_exit(100);
+	}
+	CU_ASSERT_EQUAL(waitChild(pid), 0);
+}
+
+static void posixSpawnResolvesAltsLink()
+{
+	char path[1024];
+	char *argv[] = { "tool", "argv_replaced_helper", NULL };
+	pid_t pid;
+
+	snprintf(path, sizeof(path), "%s/tool", bin_path);
+	CU_ASSERT_EQUAL_FATAL(preload_posix_spawn(&pid, path, NULL, NULL, argv, environ), 0);
+	CU_ASSERT_EQUAL(waitChild(pid), 0);
+}
+
+static void otherExecsAreUnchanged()
+{
+	char *true_argv[] = { "true", NULL };
+	char *unknown_argv[] = { "unknown", NULL };
+	char *argv[] = { "tool", "argv_replaced_helper", NULL };
+	char *other_home[] = { "HOME=/nonexistent", NULL };
+	char *cache_env[] = { "LIBALTERNATIVES_CACHE=", NULL };
+
+	CU_ASSERT_EQUAL(runExecve("true", true_argv, environ), 0);
+	CU_ASSERT_EQUAL(runExecve("unknown", unknown_argv, environ), 1);
+
+	// alts could resolve differently with these
+	if (getenv("HOME") != NULL)
+		CU_ASSERT_EQUAL(runExecve("tool", argv, other_home), 1);
+	CU_ASSERT_EQUAL(runExecve("tool", argv, cache_env), 1);
+}
+
+static void changedEnvironmentIsLeftToAlts()
+{
+	char path[1024];
+	char *argv[] = { "tool", "argv_replaced_helper", NULL };
+
+	// the library keeps the user override path it found first
+	snprintf(path, sizeof(path), "%s/tool", bin_path);
+	const pid_t pid = fork();
+	if (pid == 0) {
+		setenv("XDG_CONFIG_HOME", "/nonexistent", 1);
+		preload_execve(path, argv, environ);
+		_exit(100);
+	}
+	CU_ASSERT_EQUAL(waitChild(pid), 1);
+}
+
+static void vforkChildIsLeftToAlts()
+{
+	char path[1024];
+	char *argv[] = { "tool", "argv_replaced_helper", NULL };
+
+	snprintf(path, sizeof(path), "%s/tool", bin_path);
+	const pid_t pid = vfork();
+	if (pid == 0) {
+		preload_execve(path, argv, environ);
+		_exit(100);
+	}
+	CU_ASSERT_EQUAL(waitChild(pid), 1);
+}
+
+void addPreloadTests()
+{
+	CU_pSuite suite = CU_add_suite("Preload Tests", setupPreloadTests, cleanupPreloadTests);
+	CU_ADD_TEST(suite, execveResolvesAltsLink);
+	CU_ADD_TEST(suite, execvpAndExeclResolveAltsLink);
+	CU_ADD_TEST(suite, posixSpawnResolvesAltsLink);
+	CU_ADD_TEST(suite, otherExecsAreUnchanged);
+	CU_ADD_TEST(suite, changedEnvironmentIsLeftToAlts);
+	CU_ADD_TEST(suite, vforkChildIsLeftToAlts);
+}
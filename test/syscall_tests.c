@@ -0,0 +1,283 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <CUnit/CUnit.h>
+
+#include "../src/libalternatives.h"
+
+extern void setConfigDirectory(const char *);
+extern void setConfigPath(const char *config_path);
+
+/* System call budgets of the hot paths.
+ *
+ * The function runs in a child traced with ptrace, between two getppid()
+ * markers, and every system call it enters is counted, up to and
+ * including an execve(). The child inherits the initialized test process,
+ * so one-time costs of a fresh alts, like loading the library, are not
+ * included. The budgets are what the paths make today, so a change that
+ * adds an open or a stat fails here and has to raise the budget on
+ * purpose. Totals leave room for the allocator growing the heap.
+ */
+
+// with the daemon, exec also reads the user override to send it along,
+// and the daemon is not running; with execveat(), the target is opened
+#ifdef USE_ALTSD
+#define ALTSD_OPENS 1
+#define ALTSD_STATS 1
+#define ALTSD_SYSCALLS 4
+#else
+#define ALTSD_OPENS 0
+#define ALTSD_STATS 0
+#define ALTSD_SYSCALLS 0
+#endif
+
+#ifdef USE_EXECVEAT
+#define EXECVEAT_OPENS 1
+#else
+#define EXECVEAT_OPENS 0
+#endif
+
+#define HEAP_SYSCALLS 2
+
+struct SyscallCount
+{
+	int total;
+	int opens;
+	int stats;
+	int execs;
+};
+
+static char user_config_path[] = "/tmp/libalternatives_syscalls_XXXXXX";
+static int is_ptrace_available = 1;
+
+static int isOpen(long nr)
+{
+	return
+#ifdef SYS_open
+		nr == SYS_open ||
+#endif
+#ifdef SYS_openat2
+		nr == SYS_openat2 ||
+#endif
+		nr == SYS_openat;
+}
+
+static int isStat(long nr)
+{
+	return
+#ifdef SYS_stat
+		nr == SYS_stat || nr == SYS_lstat ||
+#endif
+#ifdef SYS_newfstatat
+		nr == SYS_newfstatat ||
+#endif
+#ifdef SYS_statx
+		nr == SYS_statx ||
+#endif
+		nr == SYS_fstat;
+}
+
+static int isExec(long nr)
+{
+	return
+#ifdef SYS_execveat
+		nr == SYS_execveat ||
+#endif
+		nr == SYS_execve;
+}
+
+// returns 0 when the counted function returned or executed, and -1 if
+// it could not be traced or failed otherwise
+static int countSyscalls(void (*function)(), struct SyscallCount *count)
+{
+	int status, markers = 0, ret = -1;
+	pid_t pid;
+
+	memset(count, 0, sizeof(*count));
+	fflush(NULL);
+
+	pid = fork();
+	if (pid < 0)
+		return -1;
+	if (pid == 0) {
+		if (ptrace(PTRACE_TRACEME, 0, NULL, NULL) < 0)
+			_exit(100);
+		raise(SIGSTOP);
+		syscall(SYS_getppid);
+		function();
+		syscall(SYS_getppid);
+		_exit(0);
+	}
+
+	if (waitpid(pid, &status, 0) != pid || !WIFSTOPPED(status))
+		goto end;
+	if (ptrace(PTRACE_SETOPTIONS, pid, NULL, PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL) < 0)
+		goto end;
+
+	while (markers < 2) {
+		struct __ptrace_syscall_info info;
+
+		if (ptrace(PTRACE_SYSCALL, pid, NULL, 0) < 0 || waitpid(pid, &status, 0) != pid)
+			goto end;
+		// the counted functions are not signalled
+		if (!WIFSTOPPED(status) || WSTOPSIG(status) != (SIGTRAP | 0x80))
+			goto end;
+
+		if (ptrace(PTRACE_GET_SYSCALL_INFO, pid, sizeof(info), &info) <= 0)
+			goto end;
+		if (info.op != PTRACE_SYSCALL_INFO_ENTRY)
+			continue;
+
+		const long nr = info.entry.nr;
+		if (nr == SYS_getppid) {
+			markers++;
+			continue;
+		}
+		if (markers == 0)
+			continue;
+
+		count->total++;
+		count->opens += isOpen(nr);
+		count->stats += isStat(nr);
+		if (isExec(nr)) {
+			count->execs++;
+			break;
+		}
+	}
+	ret = 0;
+
+end:
+	kill(pid, SIGKILL);
+	waitpid(pid, &status, 0);
+	if (ret < 0 && WIFEXITED(status) && WEXITSTATUS(status) == 100)
+		is_ptrace_available = 0;
+	return ret;
+}
+
+static int setupSyscallTests()
+{
+	const int fd = mkstemp(user_config_path);
+	if (fd < 0)
+		return -1;
+	close(fd);
+
+	// a user override for another binary, so that it is read and parsed
+	if (libalts_write_binary_configured_priority_to_file("unrelated", 10, user_config_path) < 0)
+		return -1;
+	setConfigPath(user_config_path);
+
+	unsetenv("LIBALTERNATIVES_CACHE");
+	unsetenv("LIBALTERNATIVES_TRACE");
+	unlink(libalts_get_usage_path());
+	return 0;
+}
+
+static int cleanupSyscallTests()
+{
+	setConfigPath(NULL);
+	setConfigDirectory(CONFIG_DIR);
+	return unlink(user_config_path);
+}
+
+static int countOrSkip(void (*function)(), struct SyscallCount *count)
+{
+	const int ret = countSyscalls(function, count);
+
+	if (ret < 0 && !is_ptrace_available)
+		printf("\n  ptrace is not permitted, system call budgets are not checked\n");
+	else
+		CU_ASSERT_EQUAL(ret, 0);
+	return ret;
+}
+
+static void execTest42()
+{
+	char *argv[] = { "test42", NULL };
+	libalts_exec_default(argv);
+}
+
+static void loadHighestPriority()
+{
+	struct AlternativeLink *alts = NULL;
+	libalts_load_highest_priority_binary_alternatives("multiple_alts", &alts);
+	libalts_free_alternatives_ptr(&alts);
+}
+
+static void readConfiguredPriority()
+{
+	int src = 0;
+	libalts_read_configured_priority("multiple_alts", &src);
+}
+
+// user override: openat, fstat, read, close; system override: openat;
+// directory: openat, getdents64 twice; options file:
+// openat, close of the directory, fstat, read, close; execve. Usage
+// counting is not enabled, so the usage file is not opened.
+static void execDefaultStaysInBudget()
+{
+	struct SyscallCount count;
+
+	setConfigDirectory("test/test_exec");
+	if (countOrSkip(execTest42, &count) == 0) {
+		CU_ASSERT_EQUAL(count.execs, 1);
+		CU_ASSERT(count.opens <= 4 + ALTSD_OPENS + EXECVEAT_OPENS);
+		CU_ASSERT(count.stats <= 2 + ALTSD_STATS);
+		CU_ASSERT(count.total <= 14 + ALTSD_SYSCALLS + EXECVEAT_OPENS + HEAP_SYSCALLS);
+	}
+	setConfigDirectory(CONFIG_DIR);
+}
+
+// directory: openat, getdents64 twice; options file: openat, close of
+// the directory, fstat, read, close.
+static void loadHighestPriorityStaysInBudget()
+{
+	struct SyscallCount count;
+
+	if (countOrSkip(loadHighestPriority, &count) == 0) {
+		CU_ASSERT(count.opens <= 2);
+		CU_ASSERT(count.stats <= 1);
+		CU_ASSERT(count.total <= 8 + HEAP_SYSCALLS);
+	}
+}
+
+// user override: openat, fstat, read, close; system override: openat
+static void readConfiguredPriorityStaysInBudget()
+{
+	struct SyscallCount count;
+
+	if (countOrSkip(readConfiguredPriority, &count) == 0) {
+		CU_ASSERT(count.opens <= 2);
+		CU_ASSERT(count.stats <= 1);
+		CU_ASSERT(count.total <= 5 + HEAP_SYSCALLS);
+	}
+}
+
+void addSyscallTests()
+{
+	CU_pSuite suite = CU_add_suite("System Call Budget Tests", setupSyscallTests, cleanupSyscallTests);
+	CU_ADD_TEST(suite, execDefaultStaysInBudget);
+	CU_ADD_TEST(suite, loadHighestPriorityStaysInBudget);
+	CU_ADD_TEST(suite, readConfiguredPriorityStaysInBudget);
+}
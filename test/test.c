@@ -15,7 +15,9 @@
  */
 
 #define _GNU_SOURCE
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <CUnit/CUnit.h>
@@ -95,10 +97,116 @@ static void multiple_alternative_binary()
 	CU_ASSERT_PTR_NULL(data);
 }
 
+static void exact_priority_binary()
+{
+	int ret;
+	struct AlternativeLink *data;
+
+	ret = libalts_load_exact_priority_binary_alternatives("multiple_alts", 20, &data);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_NOT_NULL(data);
+	CU_ASSERT_EQUAL(data->priority, 20);
+	CU_ASSERT_STRING_EQUAL(data->target, "/usr/bin/node20");
+	libalts_free_alternatives_ptr(&data);
+
+	ret = libalts_load_exact_priority_binary_alternatives("multiple_alts", 25, &data);
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_EQUAL(errno, ENOENT);
+	CU_ASSERT_PTR_NULL(data);
+}
+
+extern void setConfigDirectory(const char *);
+
+static void exact_priority_with_noncanonical_filename()
+{
+	char tree_path[] = "/tmp/libalternatives_legacy_XXXXXX";
+	char dir_path[512], path[1024];
+	int ret;
+	struct AlternativeLink *data;
+
+	CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(tree_path));
+	snprintf(dir_path, sizeof(dir_path), "%s/legacy", tree_path);
+	CU_ASSERT_EQUAL_FATAL(mkdir(dir_path, 0755), 0);
+	snprintf(path, sizeof(path), "%s/05-legacy.conf", dir_path);
+	FILE *f = fopen(path, "w");
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+	fputs("binary=/usr/bin/legacy\n", f);
+	fclose(f);
+
+	setConfigDirectory(tree_path);
+	ret = libalts_load_exact_priority_binary_alternatives("legacy", 5, &data);
+	setConfigDirectory(CONFIG_DIR);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_NOT_NULL(data);
+	if (data != NULL) {
+		CU_ASSERT_EQUAL(data->priority, 5);
+		CU_ASSERT_STRING_EQUAL(data->target, "/usr/bin/legacy");
+		libalts_free_alternatives_ptr(&data);
+	}
+
+	unlink(path);
+	rmdir(dir_path);
+	rmdir(tree_path);
+}
+
+extern void setStatsEnabled(int enabled);
+
+static void stats_are_only_kept_when_enabled()
+{
+	struct LibaltsStats before, after;
+	struct AlternativeLink *data;
+
+	setStatsEnabled(0);
+	CU_ASSERT_EQUAL_FATAL(libalts_get_stats(&before, sizeof(before)), 0);
+	CU_ASSERT_EQUAL(libalts_load_highest_priority_binary_alternatives("multiple_alts", &data), 0);
+	libalts_free_alternatives_ptr(&data);
+	CU_ASSERT_EQUAL_FATAL(libalts_get_stats(&after, sizeof(after)), 0);
+	CU_ASSERT_EQUAL(memcmp(&before, &after, sizeof(before)), 0);
+}
+
+static void stats_count_lookups()
+{
+	struct LibaltsStats before, after;
+	const struct LibaltsFunctionStats *calls = after.functions + LIBALTS_STATS_LOAD_HIGHEST_PRIORITY;
+	struct AlternativeLink *data;
+	unsigned long long latency_calls = 0;
+
+	setStatsEnabled(1);
+	CU_ASSERT_EQUAL_FATAL(libalts_get_stats(&before, sizeof(before)), 0);
+	CU_ASSERT_EQUAL(libalts_load_highest_priority_binary_alternatives("multiple_alts", &data), 0);
+	libalts_free_alternatives_ptr(&data);
+	CU_ASSERT_EQUAL_FATAL(libalts_get_stats(&after, sizeof(after)), 0);
+	setStatsEnabled(0);
+
+	CU_ASSERT_EQUAL(calls->calls, before.functions[LIBALTS_STATS_LOAD_HIGHEST_PRIORITY].calls + 1);
+	CU_ASSERT(calls->total_ns > before.functions[LIBALTS_STATS_LOAD_HIGHEST_PRIORITY].total_ns);
+	for (int i=0; i<LIBALTS_STATS_LATENCY_BUCKETS; i++)
+		latency_calls += calls->latency[i];
+	CU_ASSERT_EQUAL(latency_calls, calls->calls);
+
+	CU_ASSERT_EQUAL(after.directories_scanned, before.directories_scanned + 1);
+	CU_ASSERT_EQUAL(after.files_opened, before.files_opened + 1);
+	CU_ASSERT(after.bytes_parsed > before.bytes_parsed);
+	CU_ASSERT(after.allocations > before.allocations);
+	CU_ASSERT_EQUAL(after.functions[LIBALTS_STATS_LOAD_EXACT_PRIORITY].calls, before.functions[LIBALTS_STATS_LOAD_EXACT_PRIORITY].calls);
+
+	// older callers may pass a smaller structure, with fewer functions
+	CU_ASSERT_EQUAL(libalts_get_stats(&after, offsetof(struct LibaltsStats, functions[1])), 0);
+	CU_ASSERT_EQUAL(libalts_get_stats(&after, sizeof(after) + 1), -1);
+	CU_ASSERT_EQUAL(errno, EINVAL);
+}
 
 extern void addOptionsParserTests();
 extern void addConfigParserTests();
 extern void addAlternativesAppTests();
+extern void addLauncherTests();
+extern void addPreloadTests();
+extern void addSyscallTests();
+extern void addAllocTests();
+extern void addOverrideStressTests();
+#ifdef USE_ALTSD
+extern void addAltsdTests();
+#endif
 
 int main()
 {
@@ -112,10 +220,22 @@ int main()
 	CU_ADD_TEST(suite, invalid_binary);
 	CU_ADD_TEST(suite, single_alternative_binary);
 	CU_ADD_TEST(suite, multiple_alternative_binary);
+	CU_ADD_TEST(suite, exact_priority_binary);
+	CU_ADD_TEST(suite, exact_priority_with_noncanonical_filename);
+	CU_ADD_TEST(suite, stats_are_only_kept_when_enabled);
+	CU_ADD_TEST(suite, stats_count_lookups);
 
 	addOptionsParserTests();
 	addConfigParserTests();
 	addAlternativesAppTests();
+	addLauncherTests();
+	addPreloadTests();
+	addSyscallTests();
+	addAllocTests();
+	addOverrideStressTests();
+#ifdef USE_ALTSD
+	addAltsdTests();
+#endif
 
 	CU_basic_run_tests();
 	int failed_tests = CU_get_number_of_tests_failed();
@@ -1,13 +1,15 @@
 SOURCES = alternatives.c group_consistency_rules.c list_binaries.c
 HEADERS = libalternatives.h
 ALTS_binary = alts
+LAUNCHER_binary = alts-launcher
+LAUNCHER_LDFLAGS ?= -static
 OBJS = $(SOURCES:.c=.o)
 
 include ../src/Makefile.gnu.common
 
 CFLAGS += -fpie
 
-all: $(ALTS_binary)
+all: $(ALTS_binary) $(LAUNCHER_binary)
 
 ../src/libalternatives.so:
 	$(MAKE) -C ../src -f Makefile.gnu
@@ -15,10 +17,15 @@ all: $(ALTS_binary)
 $(ALTS_binary): $(OBJS) ../src/libalternatives.so
 	gcc $(LDFLAGS) $(OBJS) -o $(ALTS_binary) ../src/libalternatives.so
 
+$(LAUNCHER_binary): launcher.c
+	gcc $(CFLAGS) -Os $(LDFLAGS) $(LAUNCHER_LDFLAGS) launcher.c -o $(LAUNCHER_binary)
+
 install: $(LIBRARY)
 	install -d -t $(DESTDIR)$(BINDIR) $(ALTS_binary)
+	install -d -t $(DESTDIR)$(LIBEXECDIR)/libalternatives $(LAUNCHER_binary)
 
 clean:
 	rm -f $(OBJS)
 	rm -f $(ALTS_binary)
+	rm -f $(LAUNCHER_binary)
 
@@ -17,6 +17,7 @@
 #define _GNU_SOURCE
 #include <errno.h>
 #include <getopt.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
@@ -111,6 +112,125 @@ err:
 	return ret;
 }
 
+static int touchGeneration()
+{
+	if (libalts_bump_generation() != 0) {
+		perror(libalts_get_generation_path());
+		return 1;
+	}
+
+	return 0;
+}
+
+static int printUsage()
+{
+	struct LibaltsUsage *usage;
+	size_t size;
+
+	if (libalts_load_usage(&usage, &size) != 0) {
+		if (errno == ENOENT)
+			fprintf(stderr, "Usage counting is disabled, enable it with --reset-usage and LIBALTERNATIVES_USAGE=1\n");
+		else
+			perror(libalts_get_usage_path());
+		return 1;
+	}
+
+	printf("%12s %9s  %s\n", "executions", "priority", "program");
+	for (size_t i=0; i<size; i++)
+		printf("%12llu %9d  %s\n", usage[i].count, usage[i].priority, usage[i].binary_name);
+
+	free(usage);
+	return 0;
+}
+
+static int resetUsage()
+{
+	if (libalts_reset_usage() != 0) {
+		perror(libalts_get_usage_path());
+		return 1;
+	}
+
+	return 0;
+}
+
+static int generateLauncher(const char *dir, const char *program)
+{
+	char path[PATH_MAX];
+
+	if ((size_t)snprintf(path, sizeof(path), "%s/%s", dir, program) >= sizeof(path)) {
+		fprintf(stderr, "Launcher path too long for %s\n", program);
+		return 1;
+	}
+
+	if (libalts_generate_launcher(program, path) != 0) {
+		fprintf(stderr, "Cannot generate launcher %s: %s\n", path, strerror(errno));
+		return 1;
+	}
+
+	return 0;
+}
+
+static int generateLaunchers(const char *dir, char *programs[], int n_programs)
+{
+	char **binaries = NULL;
+	size_t n_binaries = 0;
+	int ret = 0;
+
+	if (n_programs > 0) {
+		for (int i=0; i<n_programs; i++)
+			ret |= generateLauncher(dir, programs[i]);
+		return ret;
+	}
+
+	// launchers for all installed binaries
+	if (libalts_load_available_binaries(&binaries, &n_binaries) != 0) {
+		perror(binname);
+		return 1;
+	}
+
+	for (size_t i=0; i<n_binaries; i++) {
+		ret |= generateLauncher(dir, binaries[i]);
+		free(binaries[i]);
+	}
+	free(binaries);
+
+	return ret;
+}
+
+static int exportInheritedCache(const char *program)
+{
+	if (libalts_export_inherited_cache(program) != 0) {
+		fprintf(stderr, "Cannot cache target of %s\n", program);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int printInheritedCache(const char *program, char *more_programs[], int n_more_programs)
+{
+	int ret = 0;
+
+	if (getenv("LIBALTERNATIVES_CACHE") == NULL)
+		setenv("LIBALTERNATIVES_CACHE", "", 1);
+
+	ret |= exportInheritedCache(program);
+	for (int i=0; i<n_more_programs; i++)
+		ret |= exportInheritedCache(more_programs[i]);
+
+	// shell quoted for eval
+	fputs("export LIBALTERNATIVES_CACHE='", stdout);
+	for (const char *p = getenv("LIBALTERNATIVES_CACHE"); *p; p++) {
+		if (*p == '\'')
+			fputs("'\\''", stdout);
+		else
+			putchar(*p);
+	}
+	puts("'");
+
+	return ret;
+}
+
 static void printHelp()
 {
 	puts(
@@ -120,6 +240,13 @@ static void printHelp()
 		"    alts -h         --- this help screen\n"
 		"    alts -l[name]   --- list programs or just one with given name\n"
 		"    alts -t name    --- list executed target with a given name\n"
+		"    alts --touch    --- mark installed alternatives as changed\n"
+		"    alts --inherit name... --- print shell export of resolved targets\n"
+		"       that descendant processes use without reading the configuration\n"
+		"    alts --generate-launchers dir [name...] --- write launchers that exec\n"
+		"       current targets directly, for all programs if none given\n"
+		"    alts --usage    --- print counted executions per program and priority\n"
+		"    alts --reset-usage --- create or restart the counters of executions\n"
 		"    alts [-u] [-s] -n <program> [-p <alt_priority>]\n"
 		"       sets an override with a given priority as default\n"
 		"       if priority is not set, then resets to default by removing override\n"
@@ -138,8 +265,25 @@ static void setFirstCommandOrError(int *command, int new_command)
 		*command = -1;
 }
 
+enum LongOptions
+{
+	OPT_TOUCH = 0x100,
+	OPT_INHERIT,
+	OPT_GENERATE_LAUNCHERS,
+	OPT_USAGE,
+	OPT_RESET_USAGE,
+};
+
 static int processOptions(int argc, char *argv[])
 {
+	static const struct option long_options[] = {
+		{"touch", no_argument, NULL, OPT_TOUCH},
+		{"inherit", required_argument, NULL, OPT_INHERIT},
+		{"generate-launchers", required_argument, NULL, OPT_GENERATE_LAUNCHERS},
+		{"usage", no_argument, NULL, OPT_USAGE},
+		{"reset-usage", no_argument, NULL, OPT_RESET_USAGE},
+		{NULL, 0, NULL, 0}
+	};
 	int opt;
 
 	int command = 0;
@@ -148,12 +292,15 @@ static int processOptions(int argc, char *argv[])
 	int is_system = 0, is_user = 0;
 
 	optind = 1; // reset since we call this multiple times in unit tests
-	while ((opt = getopt(argc, argv, ":hn:p:t:l::us")) != -1) {
+	while ((opt = getopt_long(argc, argv, ":hn:p:t:l::us", long_options, NULL)) != -1) {
 		switch(opt) {
 			case '?':
 				fprintf(stderr, "Invalid option on command-line.\n");
 				// fall-through
 			case 'h':
+			case OPT_TOUCH:
+			case OPT_USAGE:
+			case OPT_RESET_USAGE:
 				setFirstCommandOrError(&command, opt);
 				break;
 			case 'u':
@@ -165,6 +312,8 @@ static int processOptions(int argc, char *argv[])
 			case 'l':
 			case 'n':
 			case 't':
+			case OPT_INHERIT:
+			case OPT_GENERATE_LAUNCHERS:
 				setFirstCommandOrError(&command, opt);
 				program = optarg;
 				if (!optarg && optind < argc && argv[optind] != NULL && argv[optind][0] != '-') {
@@ -201,6 +350,18 @@ static int processOptions(int argc, char *argv[])
 			return printTargetBinary(program);
 		case 'n':
 			return setProgramOverride(program, priority, is_system, is_user);
+		case OPT_TOUCH:
+			return touchGeneration();
+		case OPT_USAGE:
+			return printUsage();
+		case OPT_RESET_USAGE:
+			return resetUsage();
+		case OPT_INHERIT:
+			// all remaining arguments are programs as well
+			return printInheritedCache(program, argv + optind, argc - optind);
+		case OPT_GENERATE_LAUNCHERS:
+			// program is the directory, remaining arguments are programs
+			return generateLaunchers(program, argv + optind, argc - optind);
 		default:
 			printf("unimplemented command %c %d\n", command, (int)command);
 			return 10;
@@ -0,0 +1,41 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Exec only alts. It is linked statically with a libalternatives built
+ * with LIBALTS_EXEC_ONLY, so executing an alternative through it skips
+ * the dynamic loader. Everything but executing the default binary is
+ * left to the full alts.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../src/libalternatives.h"
+
+int main(__attribute__((unused)) int argc, char *argv[])
+{
+	const char *name = strrchr(argv[0], '/');
+	name = (name ? name + 1 : argv[0]);
+
+	if (strcmp(name, "alts") != 0 && strcmp(name, "alts-exec") != 0)
+		return libalts_exec_default(argv);
+
+	argv[0] = (char*)"alts";
+	execv(ALTS_BINARY_PATH, argv);
+	perror("Failed to execute " ALTS_BINARY_PATH);
+	return 127;
+}
@@ -0,0 +1,414 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../src/libalternatives.h"
+#include "../src/internal.h"
+
+#define BINARY_DIR_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR)
+#define CONFIG_DIR_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+#define OVERRIDE_DIR_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR)
+
+// a client that connects and does not send its request holds the daemon
+// for at most this long
+#define CLIENT_TIMEOUT_MS 100
+
+struct BinaryEntry
+{
+	char *name;
+	int system_priority;
+
+	size_t n_priorities;
+	int *priorities; // sorted
+	struct AlternativeLink **alts; // NULL if unparsable
+	struct AlternativeLink *highest; // as the library selects it, NULL if none
+};
+
+struct BinaryTable
+{
+	struct BinaryEntry *binaries; // sorted by name
+	size_t n_binaries;
+};
+
+static const char *config_dir = CONFIG_DIR;
+static volatile sig_atomic_t is_terminated;
+
+#ifdef UNITTESTS
+void setAltsdConfigDirectory(const char *path)
+{
+	config_dir = path;
+}
+#endif
+
+static int compareInt(const void *a, const void *b)
+{
+	const int x = *(const int*)a, y = *(const int*)b;
+	return (x > y) - (x < y);
+}
+
+static int compareBinaryEntry(const void *a, const void *b)
+{
+	return strcmp(((const struct BinaryEntry*)a)->name, ((const struct BinaryEntry*)b)->name);
+}
+
+static void freeBinaryEntry(struct BinaryEntry *entry)
+{
+	for (size_t i=0; entry->alts != NULL && i<entry->n_priorities; i++) {
+		if (entry->alts[i] != NULL)
+			libalts_free_alternatives_ptr(&entry->alts[i]);
+	}
+
+	if (entry->highest != NULL)
+		libalts_free_alternatives_ptr(&entry->highest);
+	free(entry->alts);
+	free(entry->priorities);
+	free(entry->name);
+}
+
+static void freeTable(struct BinaryTable *table)
+{
+	for (size_t i=0; i<table->n_binaries; i++)
+		freeBinaryEntry(&table->binaries[i]);
+
+	free(table->binaries);
+	table->binaries = NULL;
+	table->n_binaries = 0;
+}
+
+static int loadBinaryEntry(struct BinaryEntry *entry, const char *name)
+{
+	memset(entry, 0, sizeof(*entry));
+
+	entry->name = strdup(name);
+	if (entry->name == NULL || libalts_load_binary_priorities(name, &entry->priorities, &entry->n_priorities) != 0)
+		return -1;
+	qsort(entry->priorities, entry->n_priorities, sizeof(int), compareInt);
+
+	entry->alts = calloc(entry->n_priorities, sizeof(struct AlternativeLink*));
+	if (entry->alts == NULL)
+		return -1;
+
+	for (size_t i=0; i<entry->n_priorities; i++)
+		libalts_load_exact_priority_binary_alternatives(name, entry->priorities[i], &entry->alts[i]);
+	libalts_load_highest_priority_binary_alternatives(name, &entry->highest);
+
+	entry->system_priority = libalts_read_binary_configured_priority_from_file(name, libalts_get_system_config_path());
+	return 0;
+}
+
+// watches are added before the binaries are loaded, so changes made
+// during the load trigger another one
+static int watchDirectories(int inotify_fd, char **binaries, size_t n_binaries)
+{
+	char path[PATH_MAX];
+
+	for (size_t i=0; i<n_binaries; i++) {
+		if ((size_t)snprintf(path, sizeof(path), "%s/%s", config_dir, binaries[i]) >= sizeof(path))
+			continue;
+		if (inotify_add_watch(inotify_fd, path, BINARY_DIR_EVENTS) < 0 && errno != ENOENT)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int loadTable(struct BinaryTable *table, int inotify_fd)
+{
+	char **binaries = NULL;
+	size_t n_binaries = 0;
+	struct BinaryTable new_table = { NULL, 0 };
+	int ret = -1;
+
+	if (libalts_load_available_binaries(&binaries, &n_binaries) != 0)
+		return -1;
+
+	if (watchDirectories(inotify_fd, binaries, n_binaries) < 0)
+		goto err;
+
+	new_table.binaries = calloc(n_binaries + 1, sizeof(struct BinaryEntry));
+	if (new_table.binaries == NULL)
+		goto err;
+
+	for (size_t i=0; i<n_binaries; i++) {
+		// priorities of a binary removed since the directory was listed
+		if (loadBinaryEntry(&new_table.binaries[new_table.n_binaries], binaries[i]) != 0) {
+			freeBinaryEntry(&new_table.binaries[new_table.n_binaries]);
+			continue;
+		}
+		new_table.n_binaries++;
+	}
+	qsort(new_table.binaries, new_table.n_binaries, sizeof(struct BinaryEntry), compareBinaryEntry);
+
+	freeTable(table);
+	*table = new_table;
+	new_table.binaries = NULL;
+	new_table.n_binaries = 0;
+	ret = 0;
+
+err:
+	freeTable(&new_table);
+	for (size_t i=0; i<n_binaries; i++)
+		free(binaries[i]);
+	free(binaries);
+	return ret;
+}
+
+// same selection as loadAlternatives() in the library
+static const struct AlternativeLink* resolveBinary(const struct BinaryEntry *entry, int user_priority)
+{
+	const int priority = (user_priority > 0 ? user_priority : entry->system_priority);
+
+	if (priority > 0 && entry->n_priorities > 0) {
+		const int *found = bsearch(&priority, entry->priorities, entry->n_priorities, sizeof(int), compareInt);
+		if (found != NULL && entry->alts[found - entry->priorities] != NULL)
+			return entry->alts[found - entry->priorities];
+	}
+
+	return entry->highest;
+}
+
+static size_t encodeReply(const struct AlternativeLink *alts, char *reply)
+{
+	struct ResolverReplyHeader header = { 0, 0 };
+	size_t pos = sizeof(header);
+
+	for (; alts != NULL && alts->type != ALTLINK_EOL; alts++) {
+		const struct ResolverLink link = {
+			.priority = alts->priority,
+			.type = alts->type,
+			.options = alts->options,
+			.target_size = strlen(alts->target) + 1,
+		};
+
+		if (pos + sizeof(link) + link.target_size > RESOLVER_MAX_MESSAGE) {
+			header.status = E2BIG;
+			header.n_links = 0;
+			pos = sizeof(header);
+			break;
+		}
+
+		memcpy(reply + pos, &link, sizeof(link));
+		pos += sizeof(link);
+		memcpy(reply + pos, alts->target, link.target_size);
+		pos += link.target_size;
+		header.n_links++;
+	}
+
+	if (header.n_links == 0 && header.status == 0)
+		header.status = ENOENT;
+
+	memcpy(reply, &header, sizeof(header));
+	return pos;
+}
+
+static void serveClient(int client_fd, const struct BinaryTable *table)
+{
+	struct ResolverRequest request;
+	struct timeval timeout = { 0, CLIENT_TIMEOUT_MS * 1000 };
+	static char reply[RESOLVER_MAX_MESSAGE];
+	const struct AlternativeLink *alts = NULL;
+
+	setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	if (recv(client_fd, &request, sizeof(request), 0) != sizeof(request))
+		return;
+	request.binary_name[sizeof(request.binary_name) - 1] = '\0';
+
+	const struct BinaryEntry key = { .name = request.binary_name };
+	const struct BinaryEntry *entry = bsearch(&key, table->binaries, table->n_binaries, sizeof(struct BinaryEntry), compareBinaryEntry);
+	if (entry != NULL)
+		alts = resolveBinary(entry, request.user_priority);
+
+	send(client_fd, reply, encodeReply(alts, reply), MSG_NOSIGNAL);
+}
+
+// returns 1 if the table needs to be reloaded
+static int readEvents(int inotify_fd, int config_wd, int override_wd, const char *override_name)
+{
+	char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	int is_changed = 0;
+	ssize_t len;
+
+	while ((len = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+		for (char *ptr = buffer; ptr < buffer + len; ) {
+			const struct inotify_event *event = (const struct inotify_event*)ptr;
+			ptr += sizeof(struct inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW)
+				is_changed = 1;
+			else if (event->wd == override_wd)
+				is_changed |= (event->len > 0 && strcmp(event->name, override_name) == 0);
+			else if (event->wd == config_wd)
+				is_changed |= (event->mask & IN_ISDIR) != 0; // not stamp files
+			else if ((event->mask & IN_IGNORED) == 0)
+				is_changed = 1;
+		}
+	}
+
+	return is_changed;
+}
+
+static int listenSocket(const char *socket_path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+	if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	strcpy(addr.sun_path, socket_path);
+
+	const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+
+	unlink(socket_path);
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+	    chmod(socket_path, 0666) < 0 ||
+	    listen(fd, SOMAXCONN) < 0) {
+		const int saved_error = errno;
+		close(fd);
+		errno = saved_error;
+		return -1;
+	}
+
+	return fd;
+}
+
+static void terminate(__attribute__((unused)) int signal)
+{
+	is_terminated = 1;
+}
+
+static int serve(const char *socket_path)
+{
+	struct BinaryTable table = { NULL, 0 };
+	struct pollfd fds[2];
+	struct sigaction action = { .sa_handler = terminate };
+	char *override_dir = strdup(libalts_get_system_config_path());
+	const char *override_name = strrchr(libalts_get_system_config_path(), '/');
+	int config_wd, override_wd, ret = 1;
+
+	override_name = (override_name != NULL ? override_name + 1 : libalts_get_system_config_path());
+
+	// no SA_RESTART, so poll() returns on signals
+	sigaction(SIGTERM, &action, NULL);
+	sigaction(SIGINT, &action, NULL);
+
+	fds[0].fd = listenSocket(socket_path);
+	fds[0].events = POLLIN;
+	fds[1].fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	fds[1].events = POLLIN;
+
+	if (fds[0].fd < 0 || fds[1].fd < 0 || override_dir == NULL) {
+		perror("Cannot set up altsd");
+		goto err;
+	}
+
+	config_wd = inotify_add_watch(fds[1].fd, config_dir, CONFIG_DIR_EVENTS);
+	override_wd = inotify_add_watch(fds[1].fd, dirname(override_dir), OVERRIDE_DIR_EVENTS);
+	if (config_wd < 0 || override_wd < 0 || loadTable(&table, fds[1].fd) != 0) {
+		perror("Cannot load alternatives");
+		goto err;
+	}
+
+	while (!is_terminated) {
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("poll");
+			goto err;
+		}
+
+		// reload first, so the clients that are waiting see the changes
+		if ((fds[1].revents & POLLIN) && readEvents(fds[1].fd, config_wd, override_wd, override_name)) {
+			if (loadTable(&table, fds[1].fd) != 0)
+				perror("Cannot reload alternatives, serving old ones");
+		}
+
+		if (fds[0].revents & POLLIN) {
+			const int client_fd = accept4(fds[0].fd, NULL, NULL, SOCK_CLOEXEC);
+			if (client_fd >= 0) {
+				serveClient(client_fd, &table);
+				close(client_fd);
+			}
+		}
+	}
+	ret = 0;
+
+err:
+	if (fds[0].fd >= 0) {
+		close(fds[0].fd);
+		unlink(socket_path);
+	}
+	if (fds[1].fd >= 0)
+		close(fds[1].fd);
+	freeTable(&table);
+	free(override_dir);
+	return ret;
+}
+
+static void printHelp()
+{
+	puts("altsd - resolver daemon of libalternatives\n"
+	     "\n"
+	     "    altsd [-s socket]\n"
+	     "       -s -- listen on socket path, default " ALTSD_SOCKET_PATH "\n"
+	     "       -h -- this help screen");
+}
+
+#ifdef UNITTESTS
+int altsd_main(int argc, char *argv[])
+#else
+int main(int argc, char *argv[])
+#endif
+{
+	const char *socket_path = ALTSD_SOCKET_PATH;
+	int opt;
+
+	optind = 1;
+	while ((opt = getopt(argc, argv, "hs:")) != -1) {
+		switch (opt) {
+			case 's':
+				socket_path = optarg;
+				break;
+			case 'h':
+				printHelp();
+				return 0;
+			default:
+				printHelp();
+				return 1;
+		}
+	}
+
+	return serve(socket_path);
+}
@@ -0,0 +1,111 @@
+/*  libalternatives - update-alternatives alternative
+ *  Copyright © 2026  SUSE LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Template of the launchers written by `alts --generate-launchers`. It
+ * does not link libalternatives, so a current launcher costs four
+ * stat() calls before it executes its target.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../src/libalternatives.h"
+#include "../src/internal.h"
+
+// replaced in the generated launchers
+struct LauncherData launcher_data = { .magic = LAUNCHER_MAGIC };
+
+static int isSameStamp(const char *path, const struct LauncherStamp *stamp)
+{
+	struct stat st;
+
+	if (stat(path, &st) < 0)
+		return errno == ENOENT && stamp->sec == 0 && stamp->nsec == 0;
+
+	return st.st_mtim.tv_sec == stamp->sec && st.st_mtim.tv_nsec == stamp->nsec;
+}
+
+// an options file edited in place keeps the time of its directory
+static int isOptionsFileUnchanged(const struct LauncherData *data)
+{
+	struct stat st;
+
+	if (lstat(data->options_file, &st) < 0 || !S_ISREG(st.st_mode))
+		return 0;
+
+	return (unsigned long long)st.st_ino == data->options_file_ino &&
+	       (long long)st.st_size == data->options_file_size &&
+	       st.st_ctim.tv_sec == data->options_file_ctime.sec &&
+	       st.st_ctim.tv_nsec == data->options_file_ctime.nsec;
+}
+
+// same path as libalts_get_user_config_path()
+static int getUserConfigPath(char *path, size_t size)
+{
+	const char *config_home = secure_getenv("XDG_CONFIG_HOME");
+	if (config_home != NULL)
+		return (size_t)snprintf(path, size, "%s/" CONFIG_FILENAME, config_home) < size ? 0 : -1;
+
+	config_home = secure_getenv("HOME");
+	if (config_home != NULL)
+		return (size_t)snprintf(path, size, "%s/.config/" CONFIG_FILENAME, config_home) < size ? 0 : -1;
+
+	path[0] = '\0';
+	return 0;
+}
+
+static int isUserConfigCurrent(const struct LauncherData *data)
+{
+	char path[PATH_MAX];
+	struct stat st;
+
+	if (getUserConfigPath(path, sizeof(path)) < 0)
+		return 0;
+
+	if (strcmp(path, data->user_config) == 0)
+		return path[0] == '\0' || isSameStamp(path, &data->user_config_stamp);
+
+	// a different user, which is fine while neither has an override
+	const int is_missing = (path[0] == '\0' || (stat(path, &st) < 0 && errno == ENOENT));
+	return is_missing && data->user_config_stamp.sec == 0 && data->user_config_stamp.nsec == 0;
+}
+
+int main(__attribute__((unused)) int argc, char *argv[])
+{
+	const struct LauncherData *data = &launcher_data;
+
+	// the compiler must not assume the data is what it sees here
+	__asm__ ("" : "+r" (data));
+
+	if (data->target[0] != '\0' &&
+	    isSameStamp(data->binary_dir, &data->binary_dir_stamp) &&
+	    isOptionsFileUnchanged(data) &&
+	    isSameStamp(data->system_config, &data->system_config_stamp) &&
+	    isUserConfigCurrent(data)) {
+		argv[0] = (char*)((data->options & ALTLINK_OPTIONS_KEEPARGV0) ? data->binary_name : data->target);
+		execv(data->target, argv);
+	}
+
+	// stale or broken, so let alts resolve it
+	argv[0] = (char*)data->binary_name;
+	execv(data->fallback, argv);
+	perror("Failed to execute target.");
+	return 127;
+}